@@ -1,6 +1,13 @@
 # Config setting keys
 set(SETTING_DEFAULT_MENU "DefaultMenu")
 set(SETTING_MAX_BUTTONS "MaxButtons")
+set(SETTING_MENU_DIRECTORY "Directory")
+set(SETTING_MENU_COMMAND "Command")
+set(SETTING_MENU_EXTENSIONS "Extensions")
+set(SETTING_MENU_ICON_DIRECTORY "IconDirectory")
+set(SETTING_MENU_DEFAULT_ICON "DefaultIcon")
+set(SETTING_MENU_ROWS "Menus")
+set(SETTING_ROWS "Rows")
 set(SETTING_VSYNC "VSync")
 set(SETTING_FPS_LIMIT "FPSLimit")
 set(SETTING_APPLICATION_TIMEOUT "ApplicationTimeout")
@@ -11,10 +18,13 @@ set(SETTING_BACKGROUND_IMAGE "Image")
 set(SETTING_SLIDESHOW_DIRECTORY "SlideshowDirectory")
 set(SETTING_SLIDESHOW_IMAGE_DURATION "SlideshowImageDuration")
 set(SETTING_SLIDESHOW_TRANSITION_TIME "SlideshowTransitionTime")
+set(SETTING_SLIDESHOW_HISTORY_SIZE "SlideshowHistorySize")
+set(SETTING_SLIDESHOW_PAN_ZOOM "SlideshowPanZoom")
 set(SETTING_CHROMA_KEY_COLOR "ChromaKeyColor")
 set(SETTING_BACKGROUND_OVERLAY "Overlay")
 set(SETTING_BACKGROUND_OVERLAY_COLOR "OverlayColor")
 set(SETTING_BACKGROUND_OVERLAY_OPACITY "OverlayOpacity")
+set(SETTING_IMAGE_CACHE_SIZE "ImageCacheSize")
 set(SETTING_ICON_SIZE "IconSize")
 set(SETTING_ICON_SPACING "IconSpacing")
 set(SETTING_TITLES_ENABLED "Enabled")
@@ -43,6 +53,8 @@ set(SETTING_SCROLL_INDICATOR_OUTLINE_COLOR "OutlineColor")
 set(SETTING_SCROLL_INDICATOR_OPACITY "Opacity")
 set(SETTING_ON_LAUNCH "OnLaunch")
 set(SETTING_RESET_ON_BACK "ResetOnBack")
+set(SETTING_PREFETCH_SIZE "PrefetchSize")
+set(SETTING_TEXTURE_BUDGET "TextureBudget")
 set(SETTING_MOUSE_SELECT "MouseSelect")
 set(SETTING_INHIBIT_OS_SCREENSAVER "InhibitOSScreensaver")
 set(SETTING_STARTUP_CMD "StartupCmd")
@@ -60,6 +72,9 @@ set(SETTING_CLOCK_MARGIN "Margin")
 set(SETTING_CLOCK_TIME_FORMAT "TimeFormat")
 set(SETTING_CLOCK_DATE_FORMAT "DateFormat")
 set(SETTING_CLOCK_INCLUDE_WEEKDAY "IncludeWeekday")
+set(SETTING_STATUS_ENABLED "Enabled")
+set(SETTING_STATUS_TEXT "Text")
+set(SETTING_STATUS_ALIGNMENT "Alignment")
 set(SETTING_SCREENSAVER_ENABLED "Enabled")
 set(SETTING_SCREENSAVER_IDLE_TIME "IdleTime")
 set(SETTING_SCREENSAVER_INTENSITY "Intensity")
@@ -96,6 +111,7 @@ set(SETTING_GAMEPAD_BUTTON_DPAD_RIGHT "ButtonDPadRight")
 # Default settings
 set(DEFAULT_MENU "Main")
 set(DEFAULT_MAX_BUTTONS 4)
+set(DEFAULT_ROWS 1)
 set(DEFAULT_VSYNC "true")
 set(DEFAULT_APPLICATION_TIMEOUT "7")
 set(DEFAULT_WRAP_ENTRIES "false")
@@ -107,6 +123,8 @@ set(DEFAULT_SLIDESHOW_IMAGE_DURATION "30000")
 set(DEFAULT_SLIDESHOW_IMAGE_DURATION_CONFIG "30")
 set(DEFAULT_SLIDESHOW_TRANSITION_TIME "1500")
 set(DEFAULT_SLIDESHOW_TRANSITION_TIME_CONFIG "3")
+set(DEFAULT_SLIDESHOW_HISTORY_SIZE "128")
+set(DEFAULT_SLIDESHOW_PAN_ZOOM "false")
 set(DEFAULT_CHROMA_KEY_COLOR_R "01")
 set(DEFAULT_CHROMA_KEY_COLOR_G "01")
 set(DEFAULT_CHROMA_KEY_COLOR_B "01")
@@ -117,6 +135,7 @@ set(DEFAULT_BACKGROUND_OVERLAY_COLOR_G "00")
 set(DEFAULT_BACKGROUND_OVERLAY_COLOR_B "00")
 set(DEFAULT_BACKGROUND_OVERLAY_COLOR_A "7F")
 set(DEFAULT_BACKGROUND_OVERLAY_OPACITY "50%")
+set(DEFAULT_IMAGE_CACHE_SIZE "256")
 set(DEFAULT_ICON_SIZE 256)
 set(DEFAULT_ICON_SPACING "5%")
 set(DEFAULT_FONT "OpenSans-Regular.ttf")
@@ -163,6 +182,8 @@ set(DEFAULT_SCROLL_INDICATOR_OUTLINE_COLOR_A "FF")
 set(DEFAULT_SCROLL_INDICATOR_OPACITY "100%")
 set(DEFAULT_ON_LAUNCH "Blank")
 set(DEFAULT_RESET_ON_BACK "false")
+set(DEFAULT_PREFETCH_SIZE "16")
+set(DEFAULT_TEXTURE_BUDGET "0")
 set(DEFAULT_INHIBIT_OS_SCREENSAVER "true")
 set(DEFAULT_MOUSE_SELECT "false")
 set(DEFAULT_CLOCK_ENABLED "false")
@@ -184,6 +205,8 @@ set(DEFAULT_CLOCK_FONT_SIZE "50")
 set(DEFAULT_CLOCK_TIME_FORMAT "Auto")
 set(DEFAULT_CLOCK_DATE_FORMAT "Auto")
 set(DEFAULT_CLOCK_INCLUDE_WEEKDAY "true")
+set(DEFAULT_STATUS_ENABLED "false")
+set(DEFAULT_STATUS_ALIGNMENT "Right")
 set(DEFAULT_SCREENSAVER_ENABLED "false")
 set(DEFAULT_SCREENSAVER_IDLE_TIME "300")
 set(DEFAULT_SCREENSAVER_INTENSITY "70%")
@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <SDL.h>
+#include "launcher.h"
+#include "animation.h"
+#include "debug.h"
+
+static float ease(Easing easing, float t);
+
+extern Ticks ticks;
+
+// Animations that are currently running
+static Animation *animations[MAX_ANIMATIONS];
+static int num_animations = 0;
+
+// A function to start animating a value from start to end over a duration in
+// milliseconds, the callback is called once the end value is reached
+void start_animation(Animation *animation, float *value, float start, float end, Uint32 duration, Easing easing, void (*callback)(void *data), void *data)
+{
+    if (!animation->active) {
+        if (num_animations == MAX_ANIMATIONS) {
+            log_error("Could not start animation, too many animations running");
+            *value = end;
+            if (callback != NULL)
+                callback(data);
+            return;
+        }
+        animations[num_animations++] = animation;
+    }
+    *animation = (Animation) {
+        .value = value,
+        .start = start,
+        .end = end,
+        .start_ticks = ticks.main,
+        .duration = duration,
+        .easing = easing,
+        .callback = callback,
+        .data = data,
+        .active = true
+    };
+    *value = start;
+}
+
+// A function to stop an animation, leaving its value where it is
+void stop_animation(Animation *animation)
+{
+    if (!animation->active)
+        return;
+    for (int i = 0; i < num_animations; i++) {
+        if (animations[i] == animation) {
+            animations[i] = animations[--num_animations];
+            break;
+        }
+    }
+    animation->active = false;
+}
+
+// A function to apply an easing curve to the progress of an animation
+static float ease(Easing easing, float t)
+{
+    switch (easing) {
+        case EASING_EASE_IN_OUT:
+            return t * t * (3.0f - 2.0f * t);
+        case EASING_EASE_OUT:
+            return 1.0f - (1.0f - t) * (1.0f - t) * (1.0f - t);
+        default:
+            return t;
+    }
+}
+
+// A function to update the values of all running animations based on
+// the time elapsed since they started, so they take the same time
+// regardless of the frame rate or dropped frames
+void update_animations(Uint32 current_ticks)
+{
+    for (int i = 0; i < num_animations;) {
+        Animation *animation = animations[i];
+        Uint32 elapsed = current_ticks - animation->start_ticks;
+        if (elapsed < animation->duration) {
+            float t = (float) elapsed / (float) animation->duration;
+            *animation->value = animation->start + (animation->end - animation->start) * ease(animation->easing, t);
+            i++;
+            continue;
+        }
+
+        // Finish the animation, the callback may start new animations
+        *animation->value = animation->end;
+        animations[i] = animations[--num_animations];
+        animation->active = false;
+        if (animation->callback != NULL)
+            animation->callback(animation->data);
+    }
+}
+
+// A function to determine if any animation is running, a new
+// frame is due every refresh until they all finished
+bool animations_running()
+{
+    return num_animations > 0;
+}
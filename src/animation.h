@@ -0,0 +1,6 @@
+#define MAX_ANIMATIONS 8
+
+void start_animation(Animation *animation, float *value, float start, float end, Uint32 duration, Easing easing, void (*callback)(void *data), void *data);
+void stop_animation(Animation *animation);
+void update_animations(Uint32 current_ticks);
+bool animations_running(void);
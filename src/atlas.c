@@ -0,0 +1,315 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include "launcher.h"
+#include <launcher_config.h>
+#include "atlas.h"
+#include "image.h"
+#include "textures.h"
+#include "util.h"
+#include "debug.h"
+
+static AtlasPage *add_atlas_page(void);
+static AtlasPage *get_atlas_page(SDL_Texture *texture);
+static AtlasPage *find_free_slot(int w, int h, SDL_Rect *slot);
+static void remove_atlas_page(AtlasPage *page);
+
+extern SDL_Renderer *renderer;
+
+static AtlasPage *pages     = NULL;
+static int num_pages        = 0;
+static int atlas_size       = ATLAS_SIZE;
+static Sint64 used_bytes    = 0; // Bytes of the slots of the regions on the pages
+static Batch batch;
+
+// A function to initialize the texture atlas used for icons and titles
+void init_atlas()
+{
+    // Don't exceed the texture size the renderer supports
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(renderer, &info) == 0) {
+        if (info.max_texture_width > 0)
+            atlas_size = MIN(atlas_size, info.max_texture_width);
+        if (info.max_texture_height > 0)
+            atlas_size = MIN(atlas_size, info.max_texture_height);
+    }
+    SDL_zero(batch);
+}
+
+// A function to free the texture atlas
+void quit_atlas()
+{
+    // The textures may already be destroyed together with the renderer
+    if (renderer != NULL) {
+        for (int i = 0; i < num_pages; i++)
+            destroy_texture(pages[i].texture);
+    }
+    for (int i = 0; i < num_pages; i++)
+        free(pages[i].free_slots);
+    free(pages);
+    pages = NULL;
+    num_pages = 0;
+    used_bytes = 0;
+    free(batch.vertices);
+    free(batch.indices);
+    SDL_zero(batch);
+}
+
+// A function to add an empty page to the atlas
+static AtlasPage *add_atlas_page()
+{
+    SDL_Texture *texture = track_texture(SDL_CreateTexture(renderer,
+                                             ATLAS_FORMAT,
+                                             SDL_TEXTUREACCESS_STATIC,
+                                             atlas_size,
+                                             atlas_size
+                                         ),
+                               TEXTURE_ATLAS
+                           );
+    if (texture == NULL) {
+        log_error("Could not create atlas texture\n%s", SDL_GetError());
+        return NULL;
+    }
+
+    // Clear the page so filtering at the edges of a region
+    // only picks up transparent padding
+    void *pixels = calloc((size_t) atlas_size * (size_t) atlas_size, 4);
+    if (pixels != NULL) {
+        SDL_UpdateTexture(texture, NULL, pixels, atlas_size * 4);
+        free(pixels);
+    }
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+
+    pages = realloc(pages, (size_t) (num_pages + 1) * sizeof(AtlasPage));
+    AtlasPage *page = pages + num_pages++;
+    *page = (AtlasPage) {
+        .texture = texture,
+        .num_regions = 0,
+        .shelf_y = 0,
+        .shelf_height = 0,
+        .cursor_x = 0,
+        .free_slots = NULL,
+        .num_free_slots = 0,
+        .max_free_slots = 0
+    };
+    log_debug("Created atlas page %i of %ix%i pixels", num_pages, atlas_size, atlas_size);
+    return page;
+}
+
+// A function to destroy a page of the atlas that no longer has any regions
+static void remove_atlas_page(AtlasPage *page)
+{
+    destroy_texture(page->texture);
+    free(page->free_slots);
+    int index = (int) (page - pages);
+    memmove(pages + index, pages + index + 1, (size_t) (num_pages - index - 1) * sizeof(AtlasPage));
+    num_pages--;
+    log_debug("Removed atlas page, %i pages left", num_pages);
+}
+
+// A function to get the atlas page of a texture, NULL if the
+// texture is not part of the atlas
+static AtlasPage *get_atlas_page(SDL_Texture *texture)
+{
+    for (int i = 0; i < num_pages; i++) {
+        if (pages[i].texture == texture)
+            return pages + i;
+    }
+    return NULL;
+}
+
+// A function to take the smallest free slot that can hold a region
+// of the given size out of the atlas
+static AtlasPage *find_free_slot(int w, int h, SDL_Rect *slot)
+{
+    AtlasPage *best_page = NULL;
+    int best_index = 0;
+    int best_area = 0;
+    for (int i = 0; i < num_pages; i++) {
+        for (int j = 0; j < pages[i].num_free_slots; j++) {
+            SDL_Rect *free_slot = pages[i].free_slots + j;
+            int area = free_slot->w * free_slot->h;
+            if (free_slot->w >= w && free_slot->h >= h && (best_page == NULL || area < best_area)) {
+                best_page = pages + i;
+                best_index = j;
+                best_area = area;
+            }
+        }
+    }
+    if (best_page != NULL) {
+        *slot = best_page->free_slots[best_index];
+        best_page->free_slots[best_index] = best_page->free_slots[--best_page->num_free_slots];
+    }
+    return best_page;
+}
+
+// A function to copy a surface into the atlas, a surface too large for
+// the atlas gets a texture of its own. The surface is freed.
+bool atlas_insert(SDL_Surface *surface, AtlasRegion *region)
+{
+    region->texture = NULL;
+    if (surface == NULL)
+        return false;
+
+    int w = surface->w + ATLAS_PADDING;
+    int h = surface->h + ATLAS_PADDING;
+    if (w > atlas_size || h > atlas_size) {
+        region->rect = (SDL_Rect) {0, 0, surface->w, surface->h};
+        region->slot = region->rect;
+        region->texture = track_texture(load_texture(surface), TEXTURE_MENU);
+        return region->texture != NULL;
+    }
+
+    // Reuse the slot of a freed region if one is large enough, otherwise
+    // find room on the last shelf of the last page, start a new shelf
+    // or a new page if it doesn't fit
+    SDL_Rect slot;
+    AtlasPage *page = find_free_slot(w, h, &slot);
+    bool reused = page != NULL;
+    if (!reused) {
+        page = num_pages ? pages + num_pages - 1 : add_atlas_page();
+        if (page != NULL && page->cursor_x + w > atlas_size) {
+            page->shelf_y += page->shelf_height;
+            page->shelf_height = 0;
+            page->cursor_x = 0;
+        }
+        if (page != NULL && page->shelf_y + h > atlas_size)
+            page = add_atlas_page();
+        if (page == NULL) {
+            SDL_FreeSurface(surface);
+            return false;
+        }
+        slot = (SDL_Rect) {page->cursor_x, page->shelf_y, w, h};
+    }
+
+    SDL_Surface *converted = surface;
+    if (surface->format->format != ATLAS_FORMAT)
+        converted = SDL_ConvertSurfaceFormat(surface, ATLAS_FORMAT, 0);
+    if (converted == NULL) {
+        log_error("Could not convert surface for atlas\n%s", SDL_GetError());
+        SDL_FreeSurface(surface);
+        return false;
+    }
+    region->texture = page->texture;
+    region->rect = (SDL_Rect) {slot.x, slot.y, surface->w, surface->h};
+    region->slot = slot;
+    page->num_regions++;
+    used_bytes += (Sint64) slot.w * slot.h * 4;
+
+    // Clear a reused slot that is larger than the region,
+    // so no pixels of the previous region are left next to it
+    if (reused && (slot.w != w || slot.h != h)) {
+        void *pixels = calloc((size_t) slot.w * (size_t) slot.h, 4);
+        if (pixels != NULL) {
+            SDL_UpdateTexture(page->texture, &slot, pixels, slot.w * 4);
+            free(pixels);
+        }
+    }
+    SDL_UpdateTexture(page->texture, &region->rect, converted->pixels, converted->pitch);
+    if (!reused) {
+        page->cursor_x += w;
+        if (h > page->shelf_height)
+            page->shelf_height = h;
+    }
+
+    if (converted != surface)
+        SDL_FreeSurface(converted);
+    SDL_FreeSurface(surface);
+    return true;
+}
+
+// A function to free a region of the atlas, the slot of a region inside an
+// atlas page is kept for reuse by later insertions. A page without regions
+// is destroyed to give back its video memory, unless it is the only one.
+void free_atlas_region(AtlasRegion *region)
+{
+    if (region->texture == NULL)
+        return;
+    AtlasPage *page = get_atlas_page(region->texture);
+    if (page == NULL) {
+        destroy_texture(region->texture);
+        region->texture = NULL;
+        return;
+    }
+    used_bytes -= (Sint64) region->slot.w * region->slot.h * 4;
+    if (--page->num_regions == 0 && num_pages > 1)
+        remove_atlas_page(page);
+    else {
+        if (page->num_free_slots == page->max_free_slots) {
+            page->max_free_slots = page->max_free_slots ? 2 * page->max_free_slots : ATLAS_MIN_FREE_SLOTS;
+            page->free_slots = realloc(page->free_slots, (size_t) page->max_free_slots * sizeof(SDL_Rect));
+        }
+        page->free_slots[page->num_free_slots++] = region->slot;
+    }
+    region->texture = NULL;
+}
+
+// A function to get the video memory of the atlas pages that is occupied
+// by regions, the free space of the pages is not counted
+Sint64 get_atlas_usage()
+{
+    return used_bytes;
+}
+
+// A function to queue a region of the atlas to be drawn to a rectangle
+// on the screen, quads from the same texture are drawn together. The
+// rectangle is moved by a fraction of a pixel offset for smooth motion.
+void batch_quad(AtlasRegion *region, const SDL_Rect *rect, float x_offset)
+{
+    if (region->texture == NULL)
+        return;
+    if (region->texture != batch.texture) {
+        flush_batch();
+        batch.texture = region->texture;
+        SDL_QueryTexture(batch.texture, NULL, NULL, &batch.texture_w, &batch.texture_h);
+    }
+    if (batch.num_quads == batch.max_quads) {
+        batch.max_quads = batch.max_quads ? 2 * batch.max_quads : BATCH_MIN_QUADS;
+        batch.vertices = realloc(batch.vertices, (size_t) batch.max_quads * 4 * sizeof(SDL_Vertex));
+        batch.indices = realloc(batch.indices, (size_t) batch.max_quads * 6 * sizeof(int));
+    }
+
+    // Two triangles per quad
+    float u0 = (float) region->rect.x / (float) batch.texture_w;
+    float v0 = (float) region->rect.y / (float) batch.texture_h;
+    float u1 = (float) (region->rect.x + region->rect.w) / (float) batch.texture_w;
+    float v1 = (float) (region->rect.y + region->rect.h) / (float) batch.texture_h;
+    float x0 = (float) rect->x + x_offset;
+    float y0 = (float) rect->y;
+    float x1 = (float) (rect->x + rect->w) + x_offset;
+    float y1 = (float) (rect->y + rect->h);
+    SDL_Color color = {0xFF, 0xFF, 0xFF, 0xFF};
+    SDL_Vertex *vertex = batch.vertices + 4 * batch.num_quads;
+    vertex[0] = (SDL_Vertex) {{x0, y0}, color, {u0, v0}};
+    vertex[1] = (SDL_Vertex) {{x1, y0}, color, {u1, v0}};
+    vertex[2] = (SDL_Vertex) {{x1, y1}, color, {u1, v1}};
+    vertex[3] = (SDL_Vertex) {{x0, y1}, color, {u0, v1}};
+    int first = 4 * batch.num_quads;
+    int *index = batch.indices + 6 * batch.num_quads;
+    index[0] = first;
+    index[1] = first + 1;
+    index[2] = first + 2;
+    index[3] = first;
+    index[4] = first + 2;
+    index[5] = first + 3;
+    batch.num_quads++;
+}
+
+// A function to draw the queued quads
+void flush_batch()
+{
+    if (batch.num_quads) {
+        SDL_RenderGeometry(renderer,
+            batch.texture,
+            batch.vertices,
+            4 * batch.num_quads,
+            batch.indices,
+            6 * batch.num_quads
+        );
+    }
+    batch.num_quads = 0;
+    batch.texture = NULL;
+}
@@ -0,0 +1,36 @@
+#define ATLAS_SIZE 2048
+#define ATLAS_PADDING 1
+#define ATLAS_FORMAT SDL_PIXELFORMAT_ARGB8888
+#define BATCH_MIN_QUADS 64
+#define ATLAS_MIN_FREE_SLOTS 16
+
+// Page of the texture atlas, filled shelf by shelf from the top
+typedef struct {
+    SDL_Texture *texture;
+    int num_regions;
+    int shelf_y;
+    int shelf_height;
+    int cursor_x;
+    SDL_Rect *free_slots; // Slots of freed regions that can be reused
+    int num_free_slots;
+    int max_free_slots;
+} AtlasPage;
+
+// Quads that share a texture, submitted to the renderer in one call
+typedef struct {
+    SDL_Texture *texture;
+    int texture_w;
+    int texture_h;
+    SDL_Vertex *vertices;
+    int *indices;
+    int num_quads;
+    int max_quads;
+} Batch;
+
+void init_atlas(void);
+void quit_atlas(void);
+bool atlas_insert(SDL_Surface *surface, AtlasRegion *region);
+void free_atlas_region(AtlasRegion *region);
+Sint64 get_atlas_usage(void);
+void batch_quad(AtlasRegion *region, const SDL_Rect *rect, float x_offset);
+void flush_batch(void);
@@ -0,0 +1,307 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <SDL.h>
+#include "launcher.h"
+#include <launcher_config.h>
+#include "cache.h"
+#include "util.h"
+#include "debug.h"
+#include "platform/platform.h"
+
+static Uint32 get_overlay_key(void);
+static Uint64 hash_key(const char *path, FileInfo *info, int w, int h, Uint32 format);
+static void get_cache_path(char *buffer, size_t bytes, Uint64 key, const char *extension);
+static void evict_cache(void);
+static int compare_mtime(const void *a, const void *b);
+
+extern Config config;
+extern SDL_Renderer *renderer;
+
+static bool enabled             = false;
+static Uint32 cache_format      = SDL_PIXELFORMAT_ARGB8888;
+static Sint64 cache_bytes       = 0;
+static Sint64 max_cache_bytes   = 0;
+static SDL_mutex *cache_mutex   = NULL;
+static char cache_directory[MAX_PATH_CHARS + 1];
+
+// A function to initialize the image cache
+void init_image_cache()
+{
+    if (!config.image_cache_size)
+        return;
+
+    // Find cache directory
+    char base_directory[MAX_PATH_CHARS + 1];
+    get_cache_directory(base_directory, sizeof(base_directory));
+    join_paths(cache_directory, sizeof(cache_directory), 2, base_directory, CACHE_DIRECTORY_IMAGES);
+    make_directory(cache_directory);
+    if (!directory_exists(cache_directory)) {
+        log_error("Could not create image cache directory %s, disabling feature", cache_directory);
+        return;
+    }
+
+    // Store pixels in the first 32 bit format the renderer supports natively,
+    // so they can be uploaded without any conversion
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(renderer, &info) == 0) {
+        for (Uint32 i = 0; i < info.num_texture_formats; i++) {
+            if (!SDL_ISPIXELFORMAT_FOURCC(info.texture_formats[i]) && SDL_BYTESPERPIXEL(info.texture_formats[i]) == 4) {
+                cache_format = info.texture_formats[i];
+                break;
+            }
+        }
+    }
+
+    // Get the current size of the cache
+    FileInfo *files = NULL;
+    size_t num_files = list_files(cache_directory, &files);
+    for (size_t i = 0; i < num_files; i++) {
+        cache_bytes += files[i].size;
+        free(files[i].path);
+    }
+    free(files);
+
+    max_cache_bytes = (Sint64) config.image_cache_size * BYTES_PER_MEGABYTE;
+    cache_mutex = SDL_CreateMutex();
+    enabled = true;
+    log_debug("Image cache %s contains %i MB in format %s",
+        cache_directory,
+        (int) (cache_bytes / BYTES_PER_MEGABYTE),
+        SDL_GetPixelFormatName(cache_format)
+    );
+    if (cache_bytes > max_cache_bytes)
+        evict_cache();
+}
+
+// A function to get the directory where the launcher stores cached data
+char *get_cache_directory(char *buffer, size_t bytes)
+{
+#ifdef __unix__
+    char *xdg_cache_home = getenv("XDG_CACHE_HOME");
+    if (xdg_cache_home != NULL && *xdg_cache_home != '\0')
+        join_paths(buffer, bytes, 2, xdg_cache_home, EXECUTABLE_TITLE);
+    else
+        join_paths(buffer, bytes, 3, getenv("HOME"), ".cache", EXECUTABLE_TITLE);
+#else
+    join_paths(buffer, bytes, 2, config.exe_path, "cache");
+#endif
+    return buffer;
+}
+
+// A function to close the image cache
+void quit_image_cache()
+{
+    enabled = false;
+    SDL_DestroyMutex(cache_mutex);
+    cache_mutex = NULL;
+}
+
+// A function to determine if the image cache is in use
+bool image_cache_enabled()
+{
+    return enabled;
+}
+
+// A function to get the pixel format of cached images
+Uint32 get_image_cache_format()
+{
+    return cache_format;
+}
+
+// A function to identify the overlay that is blended into cached images
+static Uint32 get_overlay_key()
+{
+    if (!config.background_overlay)
+        return 0;
+    SDL_Color *color = &config.background_overlay_color;
+    return ((Uint32) color->r << 24) | ((Uint32) color->g << 16) | ((Uint32) color->b << 8) | color->a;
+}
+
+// A function to calculate the cache key of an image, FNV-1a hash
+static Uint64 hash_key(const char *path, FileInfo *info, int w, int h, Uint32 format)
+{
+    Uint64 hash = 0xCBF29CE484222325;
+    Sint64 values[] = {info->mtime, info->size, w, h, format, get_overlay_key()};
+    for (const char *p = path; *p != '\0'; p++) {
+        hash ^= (Uint8) *p;
+        hash *= 0x100000001B3;
+    }
+    const Uint8 *bytes = (const Uint8*) values;
+    for (size_t i = 0; i < sizeof(values); i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3;
+    }
+    return hash;
+}
+
+// A function to get the path of a cached image file from its key
+static void get_cache_path(char *buffer, size_t bytes, Uint64 key, const char *extension)
+{
+    char file[30];
+    snprintf(file, sizeof(file), "%08X%08X%s", (Uint32) (key >> 32), (Uint32) key, extension);
+    join_paths(buffer, bytes, 2, cache_directory, file);
+}
+
+// A function to load a cached image, the returned surface
+// points directly into the memory mapped file
+SDL_Surface *cache_load(const char *path, int w, int h)
+{
+    if (!enabled)
+        return NULL;
+    FileInfo info;
+    if (!get_file_info(path, &info))
+        return NULL;
+
+    char cache_path[MAX_PATH_CHARS + 1];
+    Uint64 key = hash_key(path, &info, w, h, cache_format);
+    get_cache_path(cache_path, sizeof(cache_path), key, CACHE_EXTENSION);
+    CacheMapping mapping;
+    mapping.data = map_file(cache_path, &mapping.size);
+    if (mapping.data == NULL)
+        return NULL;
+
+    // Make sure the cached image matches the request
+    CacheHeader *header = (CacheHeader*) mapping.data;
+    size_t path_length = strlen(path);
+    if (mapping.size < sizeof(CacheHeader) ||
+    header->magic != CACHE_MAGIC ||
+    header->version != CACHE_VERSION ||
+    header->mtime != info.mtime ||
+    header->size != info.size ||
+    header->width != w ||
+    header->height != h ||
+    header->format != cache_format ||
+    header->overlay != get_overlay_key() ||
+    header->path_length != path_length ||
+    (size_t) header->pixel_offset + (size_t) header->pitch * (size_t) h > mapping.size ||
+    memcmp((char*) mapping.data + sizeof(CacheHeader), path, path_length)) {
+        unmap_file(mapping.data, mapping.size);
+        return NULL;
+    }
+
+    SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormatFrom((char*) mapping.data + header->pixel_offset,
+                               w,
+                               h,
+                               SDL_BITSPERPIXEL(cache_format),
+                               header->pitch,
+                               cache_format
+                           );
+    if (surface == NULL) {
+        unmap_file(mapping.data, mapping.size);
+        return NULL;
+    }
+    surface->userdata = malloc(sizeof(CacheMapping));
+    *((CacheMapping*) surface->userdata) = mapping;
+
+    // Mark the file as recently used
+    touch_file(cache_path);
+    return surface;
+}
+
+// A function to store an image in the cache, the surface must
+// already be in the cache format and target resolution
+void cache_store(const char *path, SDL_Surface *surface)
+{
+    if (!enabled || surface == NULL || surface->format->format != cache_format)
+        return;
+    FileInfo info;
+    if (!get_file_info(path, &info))
+        return;
+
+    char cache_path[MAX_PATH_CHARS + 1];
+    char tmp_path[MAX_PATH_CHARS + 1];
+    Uint64 key = hash_key(path, &info, surface->w, surface->h, cache_format);
+    get_cache_path(cache_path, sizeof(cache_path), key, CACHE_EXTENSION);
+    get_cache_path(tmp_path, sizeof(tmp_path), key, CACHE_TMP_EXTENSION);
+
+    size_t path_length = strlen(path);
+    size_t row_bytes = (size_t) surface->w * SDL_BYTESPERPIXEL(cache_format);
+    CacheHeader header = {
+        .magic = CACHE_MAGIC,
+        .version = CACHE_VERSION,
+        .mtime = info.mtime,
+        .size = info.size,
+        .width = surface->w,
+        .height = surface->h,
+        .pitch = (Sint32) row_bytes,
+        .format = cache_format,
+        .overlay = get_overlay_key(),
+        .path_length = (Uint32) path_length,
+        .pixel_offset = (Uint32) DIV_ROUND_UP(sizeof(CacheHeader) + path_length, CACHE_PIXEL_ALIGNMENT) * CACHE_PIXEL_ALIGNMENT,
+        .reserved = 0
+    };
+
+    // Write to a temporary file first so a partial image is never loaded
+    FILE *file = fopen(tmp_path, "wb");
+    if (file == NULL)
+        return;
+    static const char padding[CACHE_PIXEL_ALIGNMENT] = {0};
+    bool error = fwrite(&header, sizeof(header), 1, file) != 1 ||
+                 fwrite(path, 1, path_length, file) != path_length ||
+                 fwrite(padding, 1, header.pixel_offset - sizeof(header) - path_length, file) != header.pixel_offset - sizeof(header) - path_length;
+    for (int y = 0; y < surface->h && !error; y++) {
+        if (fwrite((Uint8*) surface->pixels + y * surface->pitch, 1, row_bytes, file) != row_bytes)
+            error = true;
+    }
+    fclose(file);
+    if (error || !replace_file(tmp_path, cache_path)) {
+        log_error("Could not write image cache file %s", cache_path);
+        remove(tmp_path);
+        return;
+    }
+
+    // Evict least recently used images if the cache is too large
+    SDL_LockMutex(cache_mutex);
+    cache_bytes += (Sint64) header.pixel_offset + (Sint64) (row_bytes * (size_t) surface->h);
+    SDL_UnlockMutex(cache_mutex);
+    if (cache_bytes > max_cache_bytes)
+        evict_cache();
+}
+
+// A function to sort cache files from least to most recently used
+static int compare_mtime(const void *a, const void *b)
+{
+    Sint64 mtime_a = ((const FileInfo*) a)->mtime;
+    Sint64 mtime_b = ((const FileInfo*) b)->mtime;
+    return (mtime_a > mtime_b) - (mtime_a < mtime_b);
+}
+
+// A function to delete the least recently used images from the cache
+static void evict_cache()
+{
+    SDL_LockMutex(cache_mutex);
+    FileInfo *files = NULL;
+    size_t num_files = list_files(cache_directory, &files);
+    cache_bytes = 0;
+    for (size_t i = 0; i < num_files; i++)
+        cache_bytes += files[i].size;
+
+    qsort(files, num_files, sizeof(FileInfo), compare_mtime);
+    Sint64 target_bytes = (Sint64) ((float) max_cache_bytes * CACHE_EVICT_FACTOR);
+    for (size_t i = 0; i < num_files; i++) {
+        if (cache_bytes > target_bytes && !remove(files[i].path)) {
+            log_debug("Evicted %s from image cache", files[i].path);
+            cache_bytes -= files[i].size;
+        }
+        free(files[i].path);
+    }
+    free(files);
+    SDL_UnlockMutex(cache_mutex);
+}
+
+// A function to determine if a surface was loaded from the cache
+bool is_cached_surface(SDL_Surface *surface)
+{
+    return surface != NULL && surface->userdata != NULL;
+}
+
+// A function to free a surface loaded from the cache and its file mapping
+void free_cached_surface(SDL_Surface *surface)
+{
+    CacheMapping *mapping = (CacheMapping*) surface->userdata;
+    SDL_FreeSurface(surface);
+    unmap_file(mapping->data, mapping->size);
+    free(mapping);
+}
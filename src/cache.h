@@ -0,0 +1,39 @@
+#define CACHE_MAGIC 0x43494C46 // "FLIC"
+#define CACHE_VERSION 3
+#define CACHE_PIXEL_ALIGNMENT 64
+#define CACHE_EXTENSION ".bin"
+#define CACHE_TMP_EXTENSION ".tmp"
+#define CACHE_DIRECTORY_IMAGES "images"
+#define CACHE_EVICT_FACTOR 0.9F
+
+// Header of a cached image file, followed by the source path and the pixels
+typedef struct {
+    Uint32 magic;
+    Uint32 version;
+    Sint64 mtime;
+    Sint64 size;
+    Sint32 width;
+    Sint32 height;
+    Sint32 pitch;
+    Uint32 format;
+    Uint32 overlay; // RGBA of the overlay blended into the pixels, 0 if none
+    Uint32 path_length;
+    Uint32 pixel_offset;
+    Uint32 reserved; // Always 0, so the header has no padding bytes
+} CacheHeader;
+
+// Memory mapping of a cached image, stored in the userdata of its surface
+typedef struct {
+    void *data;
+    size_t size;
+} CacheMapping;
+
+char *get_cache_directory(char *buffer, size_t bytes);
+void init_image_cache(void);
+void quit_image_cache(void);
+bool image_cache_enabled(void);
+Uint32 get_image_cache_format(void);
+SDL_Surface *cache_load(const char *path, int w, int h);
+void cache_store(const char *path, SDL_Surface *surface);
+bool is_cached_surface(SDL_Surface *surface);
+void free_cached_surface(SDL_Surface *surface);
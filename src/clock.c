@@ -11,6 +11,7 @@
 #include "util.h"
 #include "image.h"
 #include "clock.h"
+#include "textures.h"
 #include "debug.h"
 #include "platform/platform.h"
 
@@ -110,6 +111,17 @@ void get_time(Clock *clk)
     }
 }
 
+// A function to get the number of milliseconds until the minute changes,
+// so the clock doesn't need to wake the launcher every second
+Uint32 get_clock_timeout()
+{
+    time_t current_time = time(NULL);
+    struct tm *time_info = localtime(&current_time);
+    if (time_info == NULL)
+        return CLOCK_UPDATE_PERIOD;
+    return (Uint32) (60 - time_info->tm_sec) * 1000;
+}
+
 // A function to format the current time according to user settings
 static void format_time(Clock *clk)
 {
@@ -230,17 +242,21 @@ void init_clock(Clock *clk)
 
     // Render the time and date
     format_time(clk);
-    clk->time_texture = render_text_texture(clk->time_string,
-                            &clk->text_info,
-                            &clk->time_rect,
-                            NULL
+    clk->time_texture = track_texture(render_text_texture(clk->time_string,
+                                          &clk->text_info,
+                                          &clk->time_rect,
+                                          NULL
+                                      ),
+                            TEXTURE_CLOCK
                         );
     if (config.clock_show_date) {
         format_date(clk);
-        clk->date_texture = render_text_texture(clk->date_string,
-                                &clk->text_info,
-                                &clk->date_rect,
-                                NULL
+        clk->date_texture = track_texture(render_text_texture(clk->date_string,
+                                              &clk->text_info,
+                                              &clk->date_rect,
+                                              NULL
+                                          ),
+                                TEXTURE_CLOCK
                             );
     }
 
@@ -270,16 +286,14 @@ void render_clock(Clock *clk)
         calculate_clock_geometry(clk);
     }
     calculate_clock_positioning(clk);
-    state.clock_ready = true;
 }
 
-// A functio nto render the time to image in a separate thread
-int render_clock_async(void *data)
+// A function to render the time to image in a worker thread
+void render_clock_async(void *data)
 {
     Clock *clk = (Clock*) data;
     render_clock(clk);
-    return 0;
-} 
+}
 
 // A function to get the time format for a region
 TimeFormat get_time_format(const char *region)
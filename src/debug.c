@@ -105,6 +105,8 @@ void debug_settings()
     DEBUG_MODE(SETTING_ON_LAUNCH, MODE_SETTING_ON_LAUNCH, config.on_launch);
     DEBUG_BOOL(SETTING_WRAP_ENTRIES, config.wrap_entries);
     DEBUG_BOOL(SETTING_RESET_ON_BACK, config.reset_on_back);
+    DEBUG_INT(SETTING_PREFETCH_SIZE, config.prefetch_size);
+    DEBUG_INT(SETTING_TEXTURE_BUDGET, config.texture_budget);
     DEBUG_BOOL(SETTING_MOUSE_SELECT, config.mouse_select);
     DEBUG_BOOL(SETTING_INHIBIT_OS_SCREENSAVER, config.inhibit_os_screensaver);
     DEBUG_STR(SETTING_STARTUP_CMD, config.startup_cmd);
@@ -118,12 +120,16 @@ void debug_settings()
     DEBUG_STR(SETTING_SLIDESHOW_DIRECTORY, config.slideshow_directory);
     DEBUG_INT(SETTING_SLIDESHOW_IMAGE_DURATION, config.slideshow_image_duration / 1000);
     DEBUG_FLOAT(SETTING_SLIDESHOW_TRANSITION_TIME, ((float) config.slideshow_transition_time) / 1000.0f);
+    DEBUG_INT(SETTING_SLIDESHOW_HISTORY_SIZE, config.slideshow_history_size);
+    DEBUG_BOOL(SETTING_SLIDESHOW_PAN_ZOOM, config.slideshow_pan_zoom);
     DEBUG_BOOL(SETTING_BACKGROUND_OVERLAY, config.background_overlay);
     DEBUG_COLOR(SETTING_BACKGROUND_OVERLAY_COLOR, config.background_overlay_color);
+    DEBUG_INT(SETTING_IMAGE_CACHE_SIZE, config.image_cache_size);
     log_debug("");
 
     log_debug("======================= Layout =========================\n");
     DEBUG_INT(SETTING_MAX_BUTTONS, config.max_buttons);
+    DEBUG_INT(SETTING_ROWS, config.rows);
     DEBUG_INT(SETTING_ICON_SIZE, config.icon_size);
     DEBUG_INT(SETTING_ICON_SPACING, config.icon_spacing);
     DEBUG_STR(SETTING_VCENTER, config.vcenter[0] != '\0' ? config.vcenter : "50%");
@@ -171,6 +177,12 @@ void debug_settings()
     DEBUG_BOOL(SETTING_CLOCK_INCLUDE_WEEKDAY, config.clock_include_weekday);
     log_debug("");
 
+    log_debug("======================== Status ========================\n");
+    DEBUG_BOOL(SETTING_STATUS_ENABLED, config.status_enabled);
+    DEBUG_STR(SETTING_STATUS_TEXT, config.status_text);
+    DEBUG_MODE(SETTING_STATUS_ALIGNMENT, MODE_SETTING_ALIGNMENT, config.status_alignment);
+    log_debug("");
+
     log_debug("===================== Screensaver ======================\n");
     DEBUG_BOOL(SETTING_SCREENSAVER_ENABLED, config.screensaver_enabled);
     DEBUG_INT(SETTING_SCREENSAVER_IDLE_TIME, config.screensaver_idle_time / 1000);
@@ -188,18 +200,17 @@ void debug_menu_entries(Menu *first_menu, size_t num_menus)
     }
     log_debug("======================= Menu Entries =======================\n");
     Menu *menu = first_menu;
-    Entry *entry;
+    EntryInfo *info;
     for (size_t i = 0; i < num_menus; i ++) {
         log_debug("Menu Name: %s",menu->name);
         log_debug("Number of Entries: %i",menu->num_entries);
-        entry = menu->first_entry;
         for (size_t j = 0; j < menu->num_entries; j++) {
-            log_debug("Entry %i Title: %s",j,entry->title);
-            log_debug("Entry %i Icon Path: %s",j,entry->icon_path);
-            log_debug("Entry %i Command: %s",j,entry->cmd);
+            info = menu->entry_info + j;
+            log_debug("Entry %i Title: %s",j,info->title);
+            log_debug("Entry %i Icon Path: %s",j,info->icon_path);
+            log_debug("Entry %i Command: %s",j,info->cmd);
             if (j != menu->num_entries - 1)
                 log_debug("");
-            entry = entry->next;
         }
         if (i != num_menus - 1) {
             log_debug("----------------------------------------------------------");
@@ -240,12 +251,17 @@ void debug_hotkeys(Hotkey *hotkeys)
 void debug_slideshow(Slideshow *slideshow)
 {
     log_debug("======================== Slideshow ========================");
-    log_debug("Found %i images in directory %s:", 
-      slideshow->num_images, 
-      config.slideshow_directory
+    SDL_LockMutex(slideshow->mutex);
+    log_debug("Found %i images in directory %s%s", 
+      slideshow->num_available, 
+      config.slideshow_directory,
+      slideshow->scan_complete ? ":" : ", scan in progress:"
     );
-    for (int i = 0; i < slideshow->num_images; i++)
-        log_debug("  %s", slideshow->images[slideshow->order[i]]);
+    for (int i = 0; i < slideshow->num_images; i++) {
+        if (slideshow->images[i].path != NULL)
+            log_debug("  %s", slideshow->images[i].path);
+    }
+    SDL_UnlockMutex(slideshow->mutex);
 }
 
 // A function to debug the video settings
@@ -0,0 +1,547 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <SDL.h>
+#include "launcher.h"
+#include <launcher_config.h>
+#include "directory.h"
+#include "cache.h"
+#include "util.h"
+#include "debug.h"
+#include "platform/platform.h"
+
+static int scan_directory_async(void *data);
+static bool add_scanned_file(const char *path, void *data);
+static bool has_extension(DirectorySource *source, const char *path);
+static char *find_icon(DirectorySource *source, const char *name);
+static const char *get_base_name(const char *path);
+static void get_file_name(const char *path, char *buffer, size_t bytes);
+static char *expand_command(const char *command, const char *path, const char *name);
+static void add_directory_entry(Menu *menu, DirectoryFile *file);
+static void push_file(DirectoryFile **files, int *num_files, int *max_files, DirectoryFile *file);
+static void free_files(DirectoryFile *files, int num_files);
+static int compare_files(const void *a, const void *b);
+static void get_index_path(DirectorySource *source, char *buffer, size_t bytes);
+static void load_index(Menu *menu);
+static DirectoryFile *find_index_file(DirectorySource *source, const char *path);
+static void save_index(DirectorySource *source);
+static void update_directory_menu(Menu *menu, bool rebuild);
+static void free_source(DirectorySource *source);
+static void post_scan_event(void);
+
+extern Config config;
+
+static Menu **menus  = NULL;
+static int num_menus = 0;
+static Uint32 version = 0; // Incremented whenever the entries of a directory menu change
+static Uint32 rebuilds = 0; // Incremented whenever the entries of a directory menu are replaced
+static Uint32 scan_event_type = (Uint32) -1; // Wakes the main loop when a scan found files
+
+// Icon file extensions matched against the names of the files
+static const char *icon_extensions[] = {
+    ".png",
+    ".jpg",
+    ".jpeg",
+    ".webp",
+    ".svg"
+};
+#define NUM_ICON_EXTENSIONS sizeof(icon_extensions) / sizeof(icon_extensions[0])
+
+// A function to fill the menus that list a directory with the entries stored
+// by the previous run, and start scanning the directories in the background
+void init_directory_menus()
+{
+    scan_event_type = SDL_RegisterEvents(1);
+    for (Menu *menu = config.first_menu; menu != NULL; menu = menu->next) {
+        DirectorySource *source = menu->source;
+        if (source == NULL)
+            continue;
+        if (source->directory == NULL || source->command == NULL) {
+            log_error("Menu '%s' requires both %s and %s settings to list a directory",
+                menu->name,
+                SETTING_MENU_DIRECTORY,
+                SETTING_MENU_COMMAND
+            );
+            free_source(source);
+            menu->source = NULL;
+            continue;
+        }
+
+        menus = realloc(menus, (size_t) (num_menus + 1) * sizeof(Menu*));
+        menus[num_menus++] = menu;
+        source->first_entry = menu->num_entries;
+        source->mutex = SDL_CreateMutex();
+        SDL_AtomicSet(&source->quit, 0);
+        load_index(menu);
+        source->scan_thread = SDL_CreateThread(scan_directory_async, "Directory Scan Thread", (void*) source);
+        if (source->scan_thread == NULL) {
+            log_error("Could not create directory scan thread\n%s", SDL_GetError());
+            source->scan_complete = true;
+        }
+    }
+}
+
+// A function to stop scanning the directories of menus and free their sources
+void quit_directory_menus()
+{
+    for (int i = 0; i < num_menus; i++) {
+        DirectorySource *source = menus[i]->source;
+        SDL_AtomicSet(&source->quit, 1);
+        SDL_WaitThread(source->scan_thread, NULL);
+        free_source(source);
+        menus[i]->source = NULL;
+    }
+    free(menus);
+    menus = NULL;
+    num_menus = 0;
+}
+
+// A function to free the source of a directory menu
+static void free_source(DirectorySource *source)
+{
+    free(source->directory);
+    free(source->command);
+    free(source->icon_directory);
+    free(source->default_icon);
+    free(source->extensions);
+    free_files(source->pending, source->num_pending);
+    free(source->pending);
+    free_files(source->files, source->num_files);
+    free(source->files);
+    free_files(source->index_files, source->num_index_files);
+    free(source->index_files);
+    free_string_table(&source->index_table);
+    SDL_DestroyMutex(source->mutex);
+    free(source);
+}
+
+// A function to scan the directory of a menu in a separate thread,
+// files that are not in the menu yet are passed on as they are found
+static int scan_directory_async(void *data)
+{
+    DirectorySource *source = (DirectorySource*) data;
+    scan_files(source->directory, add_scanned_file, data);
+    if (SDL_AtomicGet(&source->quit))
+        return 0;
+
+    // Files removed since the previous run also change the menu,
+    // store the sorted files for the next run if anything changed
+    if (source->num_index_matches != source->num_index_files)
+        source->modified = true;
+    qsort(source->files, (size_t) source->num_files, sizeof(DirectoryFile), compare_files);
+    if (source->modified)
+        save_index(source);
+    log_debug("Found %i files in directory %s", source->num_files, source->directory);
+    free_files(source->index_files, source->num_index_files);
+    free(source->index_files);
+    free_string_table(&source->index_table);
+    source->index_files = NULL;
+    source->num_index_files = 0;
+
+    SDL_LockMutex(source->mutex);
+    source->scan_complete = true;
+    SDL_UnlockMutex(source->mutex);
+    if (source->modified)
+        post_scan_event();
+    return 0;
+}
+
+// A function to wake the main loop while it waits for events,
+// so it adds the files found by a scan to their menu
+static void post_scan_event()
+{
+    if (scan_event_type == (Uint32) -1)
+        return;
+    SDL_Event event;
+    SDL_zero(event);
+    event.type = scan_event_type;
+    SDL_PushEvent(&event);
+}
+
+// A function to add a file found by the directory scan
+static bool add_scanned_file(const char *path, void *data)
+{
+    DirectorySource *source = (DirectorySource*) data;
+    if (SDL_AtomicGet(&source->quit))
+        return false;
+    if (!has_extension(source, path))
+        return true;
+
+    char name[MAX_PATH_CHARS + 1];
+    get_file_name(path, name, sizeof(name));
+    DirectoryFile file = {
+        .path = strdup(path),
+        .icon_path = find_icon(source, name)
+    };
+    push_file(&source->files, &source->num_files, &source->max_files, &file);
+
+    // Files that were not in the index are added to the menu right away
+    DirectoryFile *index_file = find_index_file(source, path);
+    if (index_file != NULL) {
+        source->num_index_matches++;
+        if ((index_file->icon_path == NULL) != (file.icon_path == NULL) ||
+        (file.icon_path != NULL && strcmp(index_file->icon_path, file.icon_path)))
+            source->modified = true;
+        return true;
+    }
+    source->modified = true;
+    DirectoryFile copy = {
+        .path = strdup(file.path),
+        .icon_path = file.icon_path != NULL ? strdup(file.icon_path) : NULL
+    };
+    SDL_LockMutex(source->mutex);
+    bool first_pending = !source->num_pending;
+    push_file(&source->pending, &source->num_pending, &source->max_pending, &copy);
+    SDL_UnlockMutex(source->mutex);
+    if (first_pending)
+        post_scan_event();
+    return true;
+}
+
+// A function to determine if a file has one of the extensions of a directory menu
+static bool has_extension(DirectorySource *source, const char *path)
+{
+    if (source->extensions == NULL)
+        return true;
+    size_t length = strlen(path);
+    for (const char *extension = source->extensions; *extension != '\0';) {
+        const char *end = strchr(extension, EXTENSION_DELIMITER);
+        size_t extension_length = end != NULL ? (size_t) (end - extension) : strlen(extension);
+        if (extension_length && extension_length < length &&
+        !SDL_strncasecmp(path + length - extension_length, extension, extension_length))
+            return true;
+        if (end == NULL)
+            break;
+        extension = end + 1;
+    }
+    return false;
+}
+
+// A function to find the icon of a file, an image with the same name
+// in the icon directory or else the default icon
+static char *find_icon(DirectorySource *source, const char *name)
+{
+    if (source->icon_directory != NULL) {
+        char file[MAX_PATH_CHARS + 1];
+        char path[MAX_PATH_CHARS + 1];
+        for (size_t i = 0; i < NUM_ICON_EXTENSIONS; i++) {
+            snprintf(file, sizeof(file), "%s%s", name, icon_extensions[i]);
+            join_paths(path, sizeof(path), 2, source->icon_directory, file);
+            if (file_exists(path))
+                return strdup(path);
+        }
+    }
+    return source->default_icon != NULL ? strdup(source->default_icon) : NULL;
+}
+
+// A function to get the part of a path after the last separator
+static const char *get_base_name(const char *path)
+{
+    const char *name = path;
+    for (const char *p = path; *p != '\0'; p++) {
+        if (*p == '/' || *p == '\\')
+            name = p + 1;
+    }
+    return name;
+}
+
+// A function to get the name of a file without its directory and extension
+static void get_file_name(const char *path, char *buffer, size_t bytes)
+{
+    copy_string(buffer, get_base_name(path), bytes);
+    char *extension = strrchr(buffer, '.');
+    if (extension != NULL && extension != buffer)
+        *extension = '\0';
+}
+
+// A function to create the command of a file from the command
+// template of a directory menu
+static char *expand_command(const char *command, const char *path, const char *name)
+{
+    size_t path_length = strlen(path);
+    size_t name_length = strlen(name);
+    size_t length = 0;
+    for (const char *p = command; *p != '\0'; p++) {
+        if (p[0] == '%' && (p[1] == 'f' || p[1] == 'n')) {
+            length += p[1] == 'f' ? path_length : name_length;
+            p++;
+        }
+        else
+            length++;
+    }
+
+    char *cmd = malloc(length + 1);
+    char *out = cmd;
+    for (const char *p = command; *p != '\0'; p++) {
+        if (p[0] == '%' && p[1] == 'f') {
+            memcpy(out, path, path_length);
+            out += path_length;
+            p++;
+        }
+        else if (p[0] == '%' && p[1] == 'n') {
+            memcpy(out, name, name_length);
+            out += name_length;
+            p++;
+        }
+        else
+            *out++ = *p;
+    }
+    *out = '\0';
+    return cmd;
+}
+
+// A function to add an entry for a file to the end of a directory menu
+static void add_directory_entry(Menu *menu, DirectoryFile *file)
+{
+    char name[MAX_PATH_CHARS + 1];
+    get_file_name(file->path, name, sizeof(name));
+    char *cmd = expand_command(menu->source->command, file->path, name);
+    add_entry(menu, name, file->icon_path, cmd);
+    free(cmd);
+}
+
+// A function to add a file to the end of a list of files
+static void push_file(DirectoryFile **files, int *num_files, int *max_files, DirectoryFile *file)
+{
+    if (*num_files == *max_files) {
+        *max_files = *max_files ? 2 * *max_files : MIN_DIRECTORY_FILES;
+        *files = realloc(*files, (size_t) *max_files * sizeof(DirectoryFile));
+    }
+    (*files)[(*num_files)++] = *file;
+}
+
+// A function to free the paths of a list of files
+static void free_files(DirectoryFile *files, int num_files)
+{
+    for (int i = 0; i < num_files; i++) {
+        free(files[i].path);
+        free(files[i].icon_path);
+    }
+}
+
+// A function to sort files by name
+static int compare_files(const void *a, const void *b)
+{
+    return SDL_strcasecmp(get_base_name(((const DirectoryFile*) a)->path),
+               get_base_name(((const DirectoryFile*) b)->path)
+           );
+}
+
+// A function to get the path of the index file of a directory menu
+static void get_index_path(DirectorySource *source, char *buffer, size_t bytes)
+{
+    char directory[MAX_PATH_CHARS + 1];
+    char file[30];
+    get_cache_directory(directory, sizeof(directory));
+    snprintf(file, sizeof(file), "%s%08X%s", DIRECTORY_INDEX_PREFIX, hash_string(source->directory), DIRECTORY_INDEX_EXTENSION);
+    join_paths(buffer, bytes, 2, directory, file);
+}
+
+// A function to add the files stored by a previous run to a directory menu,
+// the index is only used if it was built with the same settings
+static void load_index(Menu *menu)
+{
+    DirectorySource *source = menu->source;
+    char *settings = NULL;
+    sprintf_alloc(&settings, "%s\n%s\n%s",
+        source->icon_directory != NULL ? source->icon_directory : "",
+        source->default_icon != NULL ? source->default_icon : "",
+        source->extensions != NULL ? source->extensions : ""
+    );
+    source->hash = settings != NULL ? hash_string(settings) : 0;
+    free(settings);
+
+    char path[MAX_PATH_CHARS + 1];
+    get_index_path(source, path, sizeof(path));
+    size_t size = 0;
+    Uint8 *data = map_file(path, &size);
+    if (data == NULL)
+        return;
+
+    DirectoryIndexHeader *header = (DirectoryIndexHeader*) data;
+    if (size < sizeof(DirectoryIndexHeader) ||
+    header->magic != DIRECTORY_INDEX_MAGIC ||
+    header->version != DIRECTORY_INDEX_VERSION ||
+    header->hash != source->hash ||
+    header->num_records > (size - sizeof(DirectoryIndexHeader)) / sizeof(DirectoryIndexRecord)) {
+        unmap_file(data, size);
+        return;
+    }
+
+    // Read records
+    source->index_files = malloc((size_t) header->num_records * sizeof(DirectoryFile));
+    size_t offset = sizeof(DirectoryIndexHeader);
+    for (Uint32 i = 0; i < header->num_records; i++) {
+        if (offset + sizeof(DirectoryIndexRecord) > size)
+            break;
+        DirectoryIndexRecord record;
+        memcpy(&record, data + offset, sizeof(DirectoryIndexRecord));
+        offset += sizeof(DirectoryIndexRecord);
+        if (!record.path_length || offset + record.path_length + record.icon_path_length > size)
+            break;
+        DirectoryFile *file = source->index_files + source->num_index_files;
+        file->path = malloc(record.path_length + 1);
+        memcpy(file->path, data + offset, record.path_length);
+        file->path[record.path_length] = '\0';
+        offset += record.path_length;
+        file->icon_path = NULL;
+        if (record.icon_path_length) {
+            file->icon_path = malloc(record.icon_path_length + 1);
+            memcpy(file->icon_path, data + offset, record.icon_path_length);
+            file->icon_path[record.icon_path_length] = '\0';
+            offset += record.icon_path_length;
+        }
+        add_directory_entry(menu, file);
+        insert_string_index(&source->index_table, file->path, source->num_index_files++);
+    }
+    unmap_file(data, size);
+    log_debug("Loaded %i entries of menu '%s' from index %s", source->num_index_files, menu->name, path);
+}
+
+// A function to find a file in the index of the previous run
+static DirectoryFile *find_index_file(DirectorySource *source, const char *path)
+{
+    int index = find_string_index(&source->index_table, path);
+    return index != -1 ? source->index_files + index : NULL;
+}
+
+// A function to store the files found by the scan in the index
+static void save_index(DirectorySource *source)
+{
+    size_t size = sizeof(DirectoryIndexHeader);
+    for (int i = 0; i < source->num_files; i++) {
+        size += sizeof(DirectoryIndexRecord) + strlen(source->files[i].path);
+        if (source->files[i].icon_path != NULL)
+            size += strlen(source->files[i].icon_path);
+    }
+    Uint8 *buffer = malloc(size);
+    DirectoryIndexHeader header = {
+        .magic = DIRECTORY_INDEX_MAGIC,
+        .version = DIRECTORY_INDEX_VERSION,
+        .hash = source->hash,
+        .num_records = (Uint32) source->num_files
+    };
+    memcpy(buffer, &header, sizeof(DirectoryIndexHeader));
+    size_t offset = sizeof(DirectoryIndexHeader);
+    for (int i = 0; i < source->num_files; i++) {
+        DirectoryFile *file = source->files + i;
+        DirectoryIndexRecord record = {
+            .path_length = (Uint32) strlen(file->path),
+            .icon_path_length = file->icon_path != NULL ? (Uint32) strlen(file->icon_path) : 0
+        };
+        memcpy(buffer + offset, &record, sizeof(DirectoryIndexRecord));
+        offset += sizeof(DirectoryIndexRecord);
+        memcpy(buffer + offset, file->path, record.path_length);
+        offset += record.path_length;
+        if (record.icon_path_length) {
+            memcpy(buffer + offset, file->icon_path, record.icon_path_length);
+            offset += record.icon_path_length;
+        }
+    }
+
+    // Write to a temporary file first so a partial index is never loaded
+    char path[MAX_PATH_CHARS + 1];
+    char tmp_path[MAX_PATH_CHARS + 1];
+    char directory[MAX_PATH_CHARS + 1];
+    get_index_path(source, path, sizeof(path));
+    snprintf(tmp_path, sizeof(tmp_path), "%s%s", path, DIRECTORY_INDEX_TMP_EXTENSION);
+    make_directory(get_cache_directory(directory, sizeof(directory)));
+    FILE *file = fopen(tmp_path, "wb");
+    bool error = file == NULL || fwrite(buffer, 1, size, file) != size;
+    if (file != NULL)
+        fclose(file);
+    if (error || !replace_file(tmp_path, path)) {
+        log_error("Could not write directory menu index %s", path);
+        remove(tmp_path);
+    }
+    else
+        log_debug("Saved %i records to directory menu index %s", source->num_files, path);
+    free(buffer);
+}
+
+// A function to add the files found by the scan to a directory menu. Once the
+// scan is complete, the entries are replaced by the sorted files if they differ,
+// which is only allowed while the menu is not shown.
+static void update_directory_menu(Menu *menu, bool rebuild)
+{
+    DirectorySource *source = menu->source;
+    SDL_LockMutex(source->mutex);
+    if (source->num_pending)
+        version++;
+    for (int i = 0; i < source->num_pending; i++)
+        add_directory_entry(menu, source->pending + i);
+    free_files(source->pending, source->num_pending);
+    source->num_pending = 0;
+    rebuild = rebuild && source->scan_complete && source->modified;
+    SDL_UnlockMutex(source->mutex);
+    if (!rebuild)
+        return;
+
+    version++;
+    rebuilds++;
+    truncate_menu(menu, source->first_entry);
+    for (int i = 0; i < source->num_files; i++)
+        add_directory_entry(menu, source->files + i);
+    free_files(source->files, source->num_files);
+    free(source->files);
+    source->files = NULL;
+    source->num_files = 0;
+    source->max_files = 0;
+    source->modified = false;
+
+    // Entries in the load range no longer have icons or titles
+    menu->load_end = MIN(menu->load_end, menu->num_entries);
+    menu->load_start = MIN(menu->load_start, menu->load_end);
+    if (menu->page*config.max_buttons + menu->highlight_position >= menu->num_entries) {
+        menu->page = 0;
+        menu->highlight_position = 0;
+    }
+    log_debug("Updated menu '%s' to %i entries", menu->name, menu->num_entries);
+}
+
+// A function to add the files found since the last frame to the directory menus,
+// the menus that are on screen are only rebuilt once they are no longer shown
+void update_directory_menus(bool (*visible)(Menu *menu))
+{
+    for (int i = 0; i < num_menus; i++)
+        update_directory_menu(menus[i], !visible(menus[i]) && !menu_loading(menus[i]));
+}
+
+// A function to check if the scan of a directory menu may still add entries,
+// either because it is running or because its files were not added yet
+bool directory_menu_scanning(Menu *menu)
+{
+    DirectorySource *source = menu->source;
+    if (source == NULL)
+        return false;
+    SDL_LockMutex(source->mutex);
+    bool scanning = !source->scan_complete || source->num_pending;
+    SDL_UnlockMutex(source->mutex);
+    return scanning;
+}
+
+// A function to get a number that changes whenever entries are
+// added to or removed from a directory menu
+Uint32 get_directory_menus_version()
+{
+    return version;
+}
+
+// A function to get a number that changes whenever the entries of a directory
+// menu are replaced, entries that were only added keep their positions
+Uint32 get_directory_menus_rebuilds()
+{
+    return rebuilds;
+}
+
+// A function to check if any directory is still being scanned or
+// has found files that were not added to its menu yet
+bool directory_menus_scanning()
+{
+    for (int i = 0; i < num_menus; i++) {
+        if (directory_menu_scanning(menus[i]))
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,29 @@
+#define DIRECTORY_INDEX_MAGIC 0x58444944 // "DIDX"
+#define DIRECTORY_INDEX_VERSION 1
+#define DIRECTORY_INDEX_PREFIX "menu-"
+#define DIRECTORY_INDEX_EXTENSION ".idx"
+#define DIRECTORY_INDEX_TMP_EXTENSION ".tmp"
+#define EXTENSION_DELIMITER ';'
+#define MIN_DIRECTORY_FILES 64
+
+// Header of a directory menu index file, followed by the records
+typedef struct {
+    Uint32 magic;
+    Uint32 version;
+    Uint32 hash;
+    Uint32 num_records;
+} DirectoryIndexHeader;
+
+// Record of a directory menu index file, followed by the file path and the icon path
+typedef struct {
+    Uint32 path_length;
+    Uint32 icon_path_length; // 0 if the file has no icon
+} DirectoryIndexRecord;
+
+void init_directory_menus(void);
+void quit_directory_menus(void);
+void update_directory_menus(bool (*visible)(Menu *menu));
+bool directory_menu_scanning(Menu *menu);
+Uint32 get_directory_menus_version(void);
+Uint32 get_directory_menus_rebuilds(void);
+bool directory_menus_scanning(void);
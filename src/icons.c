@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <SDL.h>
+#include "launcher.h"
+#include <launcher_config.h>
+#include "icons.h"
+#include "atlas.h"
+#include "util.h"
+#include "debug.h"
+#include "platform/platform.h"
+
+static Uint32 hash_icon(const char *path, int size);
+static void resize_icon_cache(Uint32 num_buckets);
+
+extern SDL_Renderer *renderer;
+
+// Hash table of the icon textures, chained by bucket
+static Icon **buckets       = NULL;
+static Uint32 num_buckets   = 0;
+static Uint32 num_icons     = 0;
+
+// A function to initialize the icon texture cache
+void init_icon_cache()
+{
+    resize_icon_cache(ICON_CACHE_MIN_BUCKETS);
+}
+
+// A function to free the icon texture cache, all icons must be released
+void quit_icon_cache()
+{
+    if (num_icons)
+        log_debug("%u icons still referenced at exit", num_icons);
+    free(buckets);
+    buckets = NULL;
+    num_buckets = 0;
+}
+
+// A function to calculate the hash of an icon from its path and size
+static Uint32 hash_icon(const char *path, int size)
+{
+    Uint32 hash = hash_string(path);
+    hash ^= (Uint32) size;
+    hash *= 0x01000193;
+    return hash;
+}
+
+// A function to rehash the icon cache into a new number of buckets
+static void resize_icon_cache(Uint32 count)
+{
+    Icon **new_buckets = calloc(count, sizeof(Icon*));
+    for (Uint32 i = 0; i < num_buckets; i++) {
+        Icon *next;
+        for (Icon *icon = buckets[i]; icon != NULL; icon = next) {
+            next = icon->next;
+            Uint32 bucket = icon->hash & (count - 1);
+            icon->next = new_buckets[bucket];
+            new_buckets[bucket] = icon;
+        }
+    }
+    free(buckets);
+    buckets = new_buckets;
+    num_buckets = count;
+}
+
+// A function to get the shared icon of a file at a size, the icon is
+// created if it isn't in the cache yet. Every call must be paired with
+// a call to release_icon().
+Icon *acquire_icon(const char *path, int size)
+{
+    if (path == NULL)
+        return NULL;
+
+    // Resolve the path so different spellings of a file share one icon
+    char canonical_path[MAX_PATH_CHARS + 1];
+    if (!get_canonical_path(path, canonical_path, sizeof(canonical_path)))
+        copy_string(canonical_path, path, sizeof(canonical_path));
+
+    Uint32 hash = hash_icon(canonical_path, size);
+    Uint32 bucket = hash & (num_buckets - 1);
+    for (Icon *icon = buckets[bucket]; icon != NULL; icon = icon->next) {
+        if (icon->hash == hash && icon->size == size && !strcmp(icon->path, canonical_path)) {
+            icon->references++;
+            return icon;
+        }
+    }
+
+    Icon *icon = malloc(sizeof(Icon));
+    *icon = (Icon) {
+        .path = strdup(canonical_path),
+        .size = size,
+        .hash = hash,
+        .references = 1,
+        .region = {NULL, {0, 0, 0, 0}, {0, 0, 0, 0}},
+        .loaded = false,
+        .loader = NULL,
+        .next = buckets[bucket]
+    };
+    buckets[bucket] = icon;
+    num_icons++;
+    if (num_icons > num_buckets)
+        resize_icon_cache(num_buckets * 2);
+    return icon;
+}
+
+// A function to release a reference to an icon, the texture
+// is destroyed once no entry uses the icon anymore
+void release_icon(Icon *icon)
+{
+    if (icon == NULL || --icon->references > 0)
+        return;
+
+    Icon **link = &buckets[icon->hash & (num_buckets - 1)];
+    while (*link != icon)
+        link = &(*link)->next;
+    *link = icon->next;
+    num_icons--;
+
+    // The texture may already be destroyed together with the renderer
+    if (renderer != NULL)
+        free_atlas_region(&icon->region);
+    free(icon->path);
+    free(icon);
+}
+
+// A function to determine if an icon still needs an entry to load it
+bool icon_needs_loading(Icon *icon)
+{
+    return icon != NULL && !icon->loaded && icon->loader == NULL;
+}
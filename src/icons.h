@@ -0,0 +1,7 @@
+#define ICON_CACHE_MIN_BUCKETS 64
+
+void init_icon_cache(void);
+void quit_icon_cache(void);
+Icon *acquire_icon(const char *path, int size);
+void release_icon(Icon *icon);
+bool icon_needs_loading(Icon *icon);
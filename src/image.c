@@ -1,13 +1,22 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <stdbool.h>
 #include <math.h>
 #include <SDL.h>
 #include <SDL_image.h>
 #include <SDL_ttf.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 #include "launcher.h"
 #include <launcher_config.h>
 #include "image.h"
+#include "cache.h"
+#include "textures.h"
+#include "slideshow.h"
 #include "util.h"
 #include "debug.h"
 #include "external/ini.h"
@@ -16,11 +25,31 @@
 #define NANOSVGRAST_IMPLEMENTATION
 #include <nanosvgrast.h>
 
+// Weights of the source pixels averaged into each destination pixel
+typedef struct {
+    int *first;
+    int *count;
+    float *weights;
+    int max_taps;
+} ResampleKernel;
+
+static Uint32 read_uint(const Uint8 *p, int bytes, bool little_endian);
+static Uint8 read_exif_orientation(const Uint8 *data, size_t size);
+static void read_jpeg_info(FILE *file, ImageInfo *info);
+static SDL_Surface *orient_surface(SDL_Surface *surface, Uint8 orientation);
+static void blend_overlay(SDL_Surface *surface, SDL_Color *color);
+static void blit_overlay(SDL_Surface *surface, SDL_Color *color);
+static bool init_resample_kernel(ResampleKernel *kernel, int src, int dst);
+static void free_resample_kernel(ResampleKernel *kernel);
+static SDL_Surface *resample_surface(SDL_Surface *surface, int w, int h);
+
 extern Config config;
 extern State state;
 extern SDL_Renderer *renderer;
 extern SDL_Texture *background_texture;
+extern Geometry geo;
 NSVGrasterizer *rasterizer = NULL;
+static SDL_mutex *text_mutex = NULL;
 
 // A function to initalize SVG rasterization
 int init_svg()
@@ -39,37 +68,168 @@ void quit_svg()
     nsvgDeleteRasterizer(rasterizer);
 }
 
-// A function to load the next slideshow background from the struct
-SDL_Surface *load_next_slideshow_background(Slideshow *slideshow, bool transition)
+// A function to initialize text rendering, SDL_ttf fonts may
+// only be used by one thread at a time
+void init_text()
+{
+    text_mutex = SDL_CreateMutex();
+    if (text_mutex == NULL)
+        log_fatal("Could not create text rendering mutex\n%s", SDL_GetError());
+}
+
+// A function to quit text rendering
+void quit_text()
+{
+    SDL_DestroyMutex(text_mutex);
+    text_mutex = NULL;
+}
+
+// A function to read an unsigned integer from a byte buffer
+static Uint32 read_uint(const Uint8 *p, int bytes, bool little_endian)
+{
+    Uint32 value = 0;
+    for (int i = 0; i < bytes; i++)
+        value |= (Uint32) p[little_endian ? i : bytes - 1 - i] << (8 * i);
+    return value;
+}
+
+// A function to find the orientation tag in a JPEG EXIF segment
+static Uint8 read_exif_orientation(const Uint8 *data, size_t size)
+{
+    if (size < 14 || memcmp(data, "Exif\0\0", 6))
+        return 1;
+    const Uint8 *tiff = data + 6;
+    size -= 6;
+    bool little_endian = tiff[0] == 'I';
+    Uint32 offset = read_uint(tiff + 4, 4, little_endian);
+    if ((size_t) offset + 2 > size)
+        return 1;
+    Uint32 num_entries = read_uint(tiff + offset, 2, little_endian);
+    for (Uint32 i = 0; i < num_entries && (size_t) offset + 2 + 12 * (i + 1) <= size; i++) {
+        const Uint8 *entry = tiff + offset + 2 + 12 * i;
+        if (read_uint(entry, 2, little_endian) == EXIF_TAG_ORIENTATION) {
+            Uint32 orientation = read_uint(entry + 8, 2, little_endian);
+            return orientation >= 1 && orientation <= 8 ? (Uint8) orientation : 1;
+        }
+    }
+    return 1;
+}
+
+// A function to walk the JPEG segments until the frame header
+static void read_jpeg_info(FILE *file, ImageInfo *info)
+{
+    Uint8 marker[4];
+    while (fread(marker, 1, sizeof(marker), file) == sizeof(marker) && marker[0] == 0xFF) {
+        Uint8 type = marker[1];
+        Uint32 length = read_uint(marker + 2, 2, false);
+        if (length < 2 || type == 0xD9 || type == 0xDA)
+            return;
+
+        // EXIF segment
+        if (type == 0xE1) {
+            Uint8 *exif = malloc(length - 2);
+            if (fread(exif, 1, length - 2, file) == length - 2)
+                info->orientation = read_exif_orientation(exif, length - 2);
+            free(exif);
+            continue;
+        }
+
+        // Start of frame, excluding DHT, JPG and DAC markers
+        if (type >= 0xC0 && type <= 0xCF && type != 0xC4 && type != 0xC8 && type != 0xCC) {
+            Uint8 frame[5];
+            if (fread(frame, 1, sizeof(frame), file) == sizeof(frame)) {
+                info->height = (Sint32) read_uint(frame + 1, 2, false);
+                info->width = (Sint32) read_uint(frame + 3, 2, false);
+                info->format = IMAGE_FORMAT_JPEG;
+            }
+            return;
+        }
+        if (fseek(file, (long) length - 2, SEEK_CUR))
+            return;
+    }
+}
+
+// A function to read the format, dimensions and orientation of an
+// image from its header without decoding it
+bool read_image_info(const char *path, ImageInfo *info)
+{
+    info->format = IMAGE_FORMAT_UNKNOWN;
+    info->width = 0;
+    info->height = 0;
+    info->orientation = 1;
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+        return false;
+
+    Uint8 header[IMAGE_HEADER_BYTES];
+    size_t bytes = fread(header, 1, sizeof(header), file);
+    if (bytes >= 24 && !memcmp(header, "\x89PNG\r\n\x1A\n", 8) && !memcmp(header + 12, "IHDR", 4)) {
+        info->format = IMAGE_FORMAT_PNG;
+        info->width = (Sint32) read_uint(header + 16, 4, false);
+        info->height = (Sint32) read_uint(header + 20, 4, false);
+    }
+    else if (bytes >= 30 && !memcmp(header, "RIFF", 4) && !memcmp(header + 8, "WEBP", 4)) {
+        const Uint8 *data = header + 20;
+        info->format = IMAGE_FORMAT_WEBP;
+        if (!memcmp(header + 12, "VP8 ", 4)) {
+            info->width = (Sint32) (read_uint(data + 6, 2, true) & 0x3FFF);
+            info->height = (Sint32) (read_uint(data + 8, 2, true) & 0x3FFF);
+        }
+        else if (!memcmp(header + 12, "VP8L", 4)) {
+            Uint32 bits = read_uint(data + 1, 4, true);
+            info->width = (Sint32) (bits & 0x3FFF) + 1;
+            info->height = (Sint32) ((bits >> 14) & 0x3FFF) + 1;
+        }
+        else if (!memcmp(header + 12, "VP8X", 4)) {
+            info->width = (Sint32) read_uint(data + 4, 3, true) + 1;
+            info->height = (Sint32) read_uint(data + 7, 3, true) + 1;
+        }
+    }
+    else if (bytes >= 4 && header[0] == 0xFF && header[1] == 0xD8 && !fseek(file, 2, SEEK_SET))
+        read_jpeg_info(file, info);
+    fclose(file);
+    return info->format != IMAGE_FORMAT_UNKNOWN && info->width > 0 && info->height > 0;
+}
+
+// A function to load the next slideshow image that can be decoded,
+// counting the number of images that were tried
+SDL_Surface *load_slideshow_surface(Slideshow *slideshow, int *attempts)
 {
     SDL_Surface *surface = NULL;
-    int initial_index = slideshow->i;
-    int attempts = 0;
+    char *path = NULL;
+    Uint8 orientation = 1;
+    int num_images = slideshow->num_available;
+    *attempts = 0;
+
+    // Leave room to pan and zoom across the image
+    int w = geo.screen_width;
+    int h = geo.screen_height;
+    if (config.slideshow_pan_zoom) {
+        w = (int) ((float) w * PAN_ZOOM_SCALE);
+        h = (int) ((float) h * PAN_ZOOM_SCALE);
+    }
     do {
-        // Increment slideshow background index and load background
-        (slideshow->i)++;
-        if (slideshow->i >= slideshow->num_images)
-            slideshow->i = 0;
-        surface = IMG_Load(slideshow->images[slideshow->order[slideshow->i]]);
-        
-        // If the loaded image has no alpha channel (e.g. JPEG), create one 
-        // so that we can have transparency for the background transition
-        if (surface != NULL && surface->format->format == SDL_PIXELFORMAT_RGB24 && transition) {
-            SDL_Surface *tmp = SDL_CreateRGBSurfaceWithFormat(0,
-                                   surface->w,
-                                   surface->h,
-                                   32,
-                                   SDL_PIXELFORMAT_ARGB8888
-                                );
-            Uint32 color = SDL_MapRGBA(tmp->format, 0, 0, 0, 0xFF);
-            SDL_FillRect(tmp, NULL, color);
-            SDL_BlitSurface(surface, NULL, tmp, NULL);
-            SDL_FreeSurface(surface);
-            surface = tmp;
-            attempts++;
-        } 
-    } while (surface == NULL && slideshow->i != initial_index && attempts < slideshow->num_images);
-    
+        // Get the next image from the slideshow and load background
+        path = get_next_slideshow_image(slideshow, &orientation);
+        if (path != NULL) {
+            surface = load_background_surface(path, w, h, orientation);
+            if (surface == NULL) {
+                log_error("Could not load slideshow image %s\n%s", path, IMG_GetError());
+                invalidate_slideshow_image(slideshow, path);
+            }
+            free(path);
+        }
+        (*attempts)++;
+    } while (surface == NULL && path != NULL && *attempts < num_images);
+    return surface;
+}
+
+// A function to leave slideshow mode if not enough images could be loaded,
+// returns the surface if the slideshow continues
+SDL_Surface *check_slideshow_surface(Slideshow *slideshow, SDL_Surface *surface, int attempts)
+{
+    int num_images = slideshow->num_available;
+
     // Switch to color background mode if we failed to load any image from the array
     if (surface == NULL) {
         log_error(
@@ -84,33 +244,429 @@ SDL_Surface *load_next_slideshow_background(Slideshow *slideshow, bool transitio
 
     // If only one image in the entire slideshow array was valid, switch to
     // single image background mode
-    else if (slideshow->i == initial_index && surface != NULL) {
+    else if (attempts == num_images && num_images > 1) {
         log_error(
             "Could only load one image from slideshow directory %s\n"
             "Changing background to single image mode",
             config.slideshow_directory
         );
-        background_texture = SDL_CreateTextureFromSurface(renderer, surface);
+        quit_slideshow();
+        background_texture = track_texture(load_texture(surface), TEXTURE_BACKGROUND);
         config.background_mode = BACKGROUND_IMAGE;
+        surface = NULL;
+    }
+    return surface;
+}
+
+// A function to load the next slideshow background from the struct
+SDL_Surface *load_next_slideshow_background(Slideshow *slideshow)
+{
+    int attempts;
+    SDL_Surface *surface = load_slideshow_surface(slideshow, &attempts);
+    return check_slideshow_surface(slideshow, surface, attempts);
+}
+
+// A function to load a background image, from the image cache if possible.
+// The image is turned upright according to its EXIF orientation.
+SDL_Surface *load_background_surface(const char *path, int w, int h, Uint8 orientation)
+{
+    SDL_Surface *surface = cache_load(path, w, h);
+    if (surface != NULL)
+        return surface;
+    surface = IMG_Load(path);
+    if (surface == NULL || (!image_cache_enabled() && !config.background_overlay && orientation <= 1))
+        return surface;
+
+    // Convert the image to the renderer format and target resolution
+    // so that it can be uploaded directly next time
+    SDL_Surface *converted = SDL_ConvertSurfaceFormat(surface, get_image_cache_format(), 0);
+    if (converted != NULL && orientation > 1) {
+        SDL_Surface *oriented = orient_surface(converted, orientation);
+        SDL_FreeSurface(converted);
+        converted = oriented;
+    }
+    if (converted == NULL) {
+        if (config.background_overlay)
+            blit_overlay(surface, &config.background_overlay_color);
+        return surface;
+    }
+    SDL_FreeSurface(surface);
+    SDL_Surface *scaled = SDL_CreateRGBSurfaceWithFormat(0,
+                              w,
+                              h,
+                              32,
+                              get_image_cache_format()
+                          );
+    if (scaled != NULL && SDL_SoftStretchLinear(converted, NULL, scaled, NULL)) {
+        SDL_FreeSurface(scaled);
+        scaled = NULL;
+    }
+
+    // Composite the overlay into the image once instead of drawing it every frame,
+    // an image that could not be scaled is left for the GPU to stretch
+    surface = scaled != NULL ? scaled : converted;
+    if (config.background_overlay)
+        blend_overlay(surface, &config.background_overlay_color);
+    if (scaled != NULL) {
+        SDL_FreeSurface(converted);
+        cache_store(path, scaled);
     }
     return surface;
 }
 
-// A function to load a new slideshow background in a separate thread
-int load_next_slideshow_background_async(void *data)
+// A function to blend a solid color over a surface of any format with a blit,
+// for images that could not be converted to 32 bits
+static void blit_overlay(SDL_Surface *surface, SDL_Color *color)
+{
+    SDL_Surface *overlay = SDL_CreateRGBSurfaceWithFormat(0, 1, 1, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (overlay == NULL) {
+        log_error("Could not blend background overlay\n%s", SDL_GetError());
+        return;
+    }
+    SDL_FillRect(overlay, NULL, SDL_MapRGBA(overlay->format, color->r, color->g, color->b, color->a));
+    SDL_SetSurfaceBlendMode(overlay, SDL_BLENDMODE_BLEND);
+    if (SDL_BlitScaled(overlay, NULL, surface, NULL))
+        log_error("Could not blend background overlay\n%s", SDL_GetError());
+    SDL_FreeSurface(overlay);
+}
+
+// A function to flip or rotate a 32 bit surface according to an EXIF orientation,
+// see https://www.exif.org/Exif2-2.PDF. Every destination pixel is read from the
+// source with a step per column and per row, in pixels.
+static SDL_Surface *orient_surface(SDL_Surface *surface, Uint8 orientation)
+{
+    bool transposed = orientation >= 5;
+    SDL_Surface *oriented = SDL_CreateRGBSurfaceWithFormat(0,
+                                transposed ? surface->h : surface->w,
+                                transposed ? surface->w : surface->h,
+                                32,
+                                surface->format->format
+                            );
+    if (oriented == NULL)
+        return NULL;
+
+    ptrdiff_t pitch = surface->pitch / 4;
+    ptrdiff_t right = surface->w - 1;
+    ptrdiff_t bottom = (ptrdiff_t) (surface->h - 1) * pitch;
+    ptrdiff_t origin = 0;
+    ptrdiff_t step_x = 1;
+    ptrdiff_t step_y = pitch;
+    switch (orientation) {
+        case 2: // Mirrored horizontally
+            origin = right;
+            step_x = -1;
+            break;
+        case 3: // Rotated 180 degrees
+            origin = right + bottom;
+            step_x = -1;
+            step_y = -pitch;
+            break;
+        case 4: // Mirrored vertically
+            origin = bottom;
+            step_y = -pitch;
+            break;
+        case 5: // Transposed
+            step_x = pitch;
+            step_y = 1;
+            break;
+        case 6: // Rotated 90 degrees clockwise
+            origin = bottom;
+            step_x = -pitch;
+            step_y = 1;
+            break;
+        case 7: // Transposed across the other diagonal
+            origin = right + bottom;
+            step_x = -pitch;
+            step_y = -1;
+            break;
+        case 8: // Rotated 90 degrees counterclockwise
+            origin = right;
+            step_x = pitch;
+            step_y = -1;
+            break;
+    }
+
+    SDL_LockSurface(surface);
+    const Uint32 *pixels = (const Uint32*) surface->pixels;
+    for (int y = 0; y < oriented->h; y++) {
+        Uint32 *row = (Uint32*) ((Uint8*) oriented->pixels + (size_t) y * (size_t) oriented->pitch);
+        const Uint32 *source = pixels + origin + y * step_y;
+        for (int x = 0; x < oriented->w; x++, source += step_x)
+            row[x] = *source;
+    }
+    SDL_UnlockSurface(surface);
+    return oriented;
+}
+
+// A function to blend a solid color over the pixels of a 32 bit surface,
+// the alpha channel of the surface is left unchanged
+static void blend_overlay(SDL_Surface *surface, SDL_Color *color)
+{
+    // Build the weight and the premultiplied color for each byte of a pixel,
+    // the byte order depends on the pixel format
+    Uint8 inverse[4];
+    Uint16 addend[4];
+    Uint8 color_bytes[4];
+    Uint8 alpha_bytes[4];
+    Uint32 color_pixel = SDL_MapRGB(surface->format, color->r, color->g, color->b);
+    memcpy(color_bytes, &color_pixel, sizeof(color_bytes));
+    memcpy(alpha_bytes, &surface->format->Amask, sizeof(alpha_bytes));
+    for (int i = 0; i < 4; i++) {
+        inverse[i] = alpha_bytes[i] ? 0xFF : (Uint8) (0xFF - color->a);
+        addend[i] = alpha_bytes[i] ? 0 : (Uint16) (color_bytes[i] * color->a);
+    }
+
+    int row_bytes = surface->w * 4;
+    for (int y = 0; y < surface->h; y++) {
+        Uint8 *p = (Uint8*) surface->pixels + y * surface->pitch;
+        int x = 0;
+
+        // Blend 4 pixels at a time, dividing by 255 with (v + 128 + ((v + 128) >> 8)) >> 8
+#if defined(__SSE2__)
+        __m128i zero = _mm_setzero_si128();
+        __m128i inverse_16 = _mm_setr_epi16(inverse[0], inverse[1], inverse[2], inverse[3],
+                                 inverse[0], inverse[1], inverse[2], inverse[3]);
+        __m128i addend_16 = _mm_setr_epi16((short) (addend[0] + 128), (short) (addend[1] + 128),
+                                (short) (addend[2] + 128), (short) (addend[3] + 128),
+                                (short) (addend[0] + 128), (short) (addend[1] + 128),
+                                (short) (addend[2] + 128), (short) (addend[3] + 128));
+        for (; x + 16 <= row_bytes; x += 16) {
+            __m128i pixels = _mm_loadu_si128((__m128i*) (p + x));
+            __m128i low = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(pixels, zero), inverse_16), addend_16);
+            __m128i high = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(pixels, zero), inverse_16), addend_16);
+            low = _mm_srli_epi16(_mm_add_epi16(low, _mm_srli_epi16(low, 8)), 8);
+            high = _mm_srli_epi16(_mm_add_epi16(high, _mm_srli_epi16(high, 8)), 8);
+            _mm_storeu_si128((__m128i*) (p + x), _mm_packus_epi16(low, high));
+        }
+#elif defined(__ARM_NEON)
+        Uint32 inverse_32;
+        memcpy(&inverse_32, inverse, sizeof(inverse_32));
+        uint8x8_t inverse_8 = vreinterpret_u8_u32(vdup_n_u32(inverse_32));
+        uint16x8_t addend_16 = {
+            (Uint16) (addend[0] + 128), (Uint16) (addend[1] + 128), (Uint16) (addend[2] + 128), (Uint16) (addend[3] + 128),
+            (Uint16) (addend[0] + 128), (Uint16) (addend[1] + 128), (Uint16) (addend[2] + 128), (Uint16) (addend[3] + 128)
+        };
+        for (; x + 16 <= row_bytes; x += 16) {
+            uint8x16_t pixels = vld1q_u8(p + x);
+            uint16x8_t low = vmlal_u8(addend_16, vget_low_u8(pixels), inverse_8);
+            uint16x8_t high = vmlal_u8(addend_16, vget_high_u8(pixels), inverse_8);
+            low = vaddq_u16(low, vshrq_n_u16(low, 8));
+            high = vaddq_u16(high, vshrq_n_u16(high, 8));
+            vst1q_u8(p + x, vcombine_u8(vshrn_n_u16(low, 8), vshrn_n_u16(high, 8)));
+        }
+#endif
+        // Blend the remaining pixels
+        for (; x < row_bytes; x++) {
+            Uint32 v = (Uint32) p[x] * inverse[x & 3] + addend[x & 3] + 128;
+            p[x] = (Uint8) ((v + (v >> 8)) >> 8);
+        }
+    }
+}
+
+// Vector of the 4 channels of a pixel for the resampling filter
+#if defined(__SSE2__)
+typedef __m128 Vec4;
+
+static inline Vec4 vec4_from_pixel(const Uint8 *p)
+{
+    int pixel;
+    memcpy(&pixel, p, sizeof(pixel));
+    __m128i zero = _mm_setzero_si128();
+    __m128i v = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(pixel), zero), zero);
+    return _mm_cvtepi32_ps(v);
+}
+static inline Vec4 vec4_set(float a, float b, float c, float d) { return _mm_setr_ps(a, b, c, d); }
+static inline Vec4 vec4_zero(void) { return _mm_setzero_ps(); }
+static inline Vec4 vec4_load(const float *p) { return _mm_loadu_ps(p); }
+static inline void vec4_store(float *p, Vec4 v) { _mm_storeu_ps(p, v); }
+static inline Vec4 vec4_mul(Vec4 a, Vec4 b) { return _mm_mul_ps(a, b); }
+static inline Vec4 vec4_madd(Vec4 acc, Vec4 v, float w) { return _mm_add_ps(acc, _mm_mul_ps(v, _mm_set1_ps(w))); }
+#elif defined(__ARM_NEON)
+typedef float32x4_t Vec4;
+
+static inline Vec4 vec4_from_pixel(const Uint8 *p)
+{
+    Uint32 pixel;
+    memcpy(&pixel, p, sizeof(pixel));
+    uint16x8_t v = vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(pixel)));
+    return vcvtq_f32_u32(vmovl_u16(vget_low_u16(v)));
+}
+static inline Vec4 vec4_set(float a, float b, float c, float d)
+{
+    float v[4] = {a, b, c, d};
+    return vld1q_f32(v);
+}
+static inline Vec4 vec4_zero(void) { return vdupq_n_f32(0.0f); }
+static inline Vec4 vec4_load(const float *p) { return vld1q_f32(p); }
+static inline void vec4_store(float *p, Vec4 v) { vst1q_f32(p, v); }
+static inline Vec4 vec4_mul(Vec4 a, Vec4 b) { return vmulq_f32(a, b); }
+static inline Vec4 vec4_madd(Vec4 acc, Vec4 v, float w) { return vmlaq_n_f32(acc, v, w); }
+#else
+typedef struct {
+    float v[4];
+} Vec4;
+
+static inline Vec4 vec4_from_pixel(const Uint8 *p) { return (Vec4) {{p[0], p[1], p[2], p[3]}}; }
+static inline Vec4 vec4_set(float a, float b, float c, float d) { return (Vec4) {{a, b, c, d}}; }
+static inline Vec4 vec4_zero(void) { return (Vec4) {{0.0f, 0.0f, 0.0f, 0.0f}}; }
+static inline Vec4 vec4_load(const float *p) { return (Vec4) {{p[0], p[1], p[2], p[3]}}; }
+static inline void vec4_store(float *p, Vec4 v) { memcpy(p, v.v, sizeof(v.v)); }
+static inline Vec4 vec4_mul(Vec4 a, Vec4 b)
+{
+    for (int i = 0; i < 4; i++)
+        a.v[i] *= b.v[i];
+    return a;
+}
+static inline Vec4 vec4_madd(Vec4 acc, Vec4 v, float w)
+{
+    for (int i = 0; i < 4; i++)
+        acc.v[i] += v.v[i] * w;
+    return acc;
+}
+#endif
+
+// A function to calculate the area-averaging weights for downscaling
+// a row or column of src pixels to dst pixels
+static bool init_resample_kernel(ResampleKernel *kernel, int src, int dst)
+{
+    float scale = (float) src / (float) dst;
+    kernel->max_taps = (int) ceilf(scale) + 1;
+    kernel->first = malloc((size_t) dst * sizeof(int));
+    kernel->count = malloc((size_t) dst * sizeof(int));
+    kernel->weights = malloc((size_t) dst * (size_t) kernel->max_taps * sizeof(float));
+    if (kernel->first == NULL || kernel->count == NULL || kernel->weights == NULL) {
+        free_resample_kernel(kernel);
+        return false;
+    }
+
+    // Weight every source pixel by how much of it the destination pixel covers
+    for (int d = 0; d < dst; d++) {
+        float start = (float) d * scale;
+        float end = fminf(start + scale, (float) src);
+        int first = (int) start;
+        int last = MIN((int) ceilf(end), src);
+        kernel->first[d] = first;
+        kernel->count[d] = MIN(last - first, kernel->max_taps);
+        for (int i = 0; i < kernel->count[d]; i++) {
+            float coverage = fminf((float) (first + i + 1), end) - fmaxf((float) (first + i), start);
+            kernel->weights[d * kernel->max_taps + i] = coverage / scale;
+        }
+    }
+    return true;
+}
+
+// A function to free the weights of a resampling kernel
+static void free_resample_kernel(ResampleKernel *kernel)
+{
+    free(kernel->first);
+    free(kernel->count);
+    free(kernel->weights);
+}
+
+// A function to downscale a BGRA32 surface with an area-averaging filter,
+// colors are averaged with premultiplied alpha so transparent pixels don't
+// darken the edges
+static SDL_Surface *resample_surface(SDL_Surface *surface, int w, int h)
+{
+    ResampleKernel horizontal, vertical;
+    if (!init_resample_kernel(&horizontal, surface->w, w))
+        return NULL;
+    if (!init_resample_kernel(&vertical, surface->h, h)) {
+        free_resample_kernel(&horizontal);
+        return NULL;
+    }
+    float *row = malloc((size_t) surface->w * 4 * sizeof(float));
+    float *columns = malloc((size_t) w * (size_t) surface->h * 4 * sizeof(float));
+    SDL_Surface *scaled = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_BGRA32);
+    if (row == NULL || columns == NULL || scaled == NULL) {
+        SDL_FreeSurface(scaled);
+        scaled = NULL;
+        goto cleanup;
+    }
+
+    // Premultiply each source row, then average it horizontally
+    for (int y = 0; y < surface->h; y++) {
+        const Uint8 *p = (const Uint8*) surface->pixels + y * surface->pitch;
+        for (int x = 0; x < surface->w; x++, p += 4) {
+            float alpha = (float) p[3] / 255.0f;
+            vec4_store(row + 4 * x, vec4_mul(vec4_from_pixel(p), vec4_set(alpha, alpha, alpha, 1.0f)));
+        }
+        for (int x = 0; x < w; x++) {
+            Vec4 sum = vec4_zero();
+            const float *src = row + 4 * horizontal.first[x];
+            const float *weights = horizontal.weights + x * horizontal.max_taps;
+            for (int i = 0; i < horizontal.count[x]; i++)
+                sum = vec4_madd(sum, vec4_load(src + 4 * i), weights[i]);
+            vec4_store(columns + 4 * ((size_t) y * (size_t) w + (size_t) x), sum);
+        }
+    }
+
+    // Average the columns vertically and undo the premultiplication
+    for (int y = 0; y < h; y++) {
+        Uint8 *p = (Uint8*) scaled->pixels + y * scaled->pitch;
+        const float *weights = vertical.weights + y * vertical.max_taps;
+        for (int x = 0; x < w; x++, p += 4) {
+            Vec4 sum = vec4_zero();
+            const float *src = columns + 4 * ((size_t) vertical.first[y] * (size_t) w + (size_t) x);
+            for (int i = 0; i < vertical.count[y]; i++)
+                sum = vec4_madd(sum, vec4_load(src + 4 * (size_t) i * (size_t) w), weights[i]);
+            float pixel[4];
+            vec4_store(pixel, sum);
+            float factor = pixel[3] > 0.0f ? 255.0f / pixel[3] : 0.0f;
+            for (int c = 0; c < 3; c++)
+                p[c] = (Uint8) fminf(pixel[c] * factor + 0.5f, 255.0f);
+            p[3] = (Uint8) fminf(pixel[3] + 0.5f, 255.0f);
+        }
+    }
+
+cleanup:
+    free(row);
+    free(columns);
+    free_resample_kernel(&horizontal);
+    free_resample_kernel(&vertical);
+    return scaled;
+}
+
+// A function to load an icon downscaled to fit its display size with its
+// aspect ratio kept, so the GPU doesn't have to minify a large texture every
+// frame. Icons that already fit are left for the GPU to stretch.
+SDL_Surface *load_icon_surface(const char *path, int size)
+{
+    SDL_Surface *surface = load_surface(path);
+    if (surface == NULL || (surface->w <= size && surface->h <= size))
+        return surface;
+
+    SDL_Surface *converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_BGRA32, 0);
+    if (converted == NULL)
+        return surface;
+    int longest = surface->w > surface->h ? surface->w : surface->h;
+    int w = (int) (((Sint64) surface->w * size + longest / 2) / longest);
+    int h = (int) (((Sint64) surface->h * size + longest / 2) / longest);
+    SDL_Surface *scaled = resample_surface(converted, w > 0 ? w : 1, h > 0 ? h : 1);
+    SDL_FreeSurface(converted);
+    if (scaled == NULL)
+        return surface;
+    SDL_FreeSurface(surface);
+    return scaled;
+}
+
+// A function to load a new slideshow background in a worker thread
+void load_next_slideshow_background_async(void *data)
 {
     Slideshow *slideshow = (Slideshow*) data;
-    slideshow->transition_surface = load_next_slideshow_background(slideshow, true);
-    state.slideshow_background_rendering = false;
-    state.slideshow_background_ready = true;
-    return 0;
+    slideshow->transition_surface = load_slideshow_surface(slideshow, &slideshow->load_attempts);
 }
 
 // A function to load a texture from a file
 SDL_Texture *load_texture_from_file(const char *path)
+{
+    return load_texture(load_surface(path));
+}
+
+// A function to load a surface from a file, safe to call from any thread
+SDL_Surface *load_surface(const char *path)
 {
     SDL_Surface *surface = NULL;
-    SDL_Texture *texture = NULL;
     if (path != NULL) {
         surface = IMG_Load(path);
         if (surface == NULL) {
@@ -120,10 +676,8 @@ SDL_Texture *load_texture_from_file(const char *path)
                 IMG_GetError()
             );
         }
-        else
-            texture = load_texture(surface);
     }
-    return texture;
+    return surface;
 }
 
 // A function to load a texture from a    SDL surface
@@ -133,6 +687,23 @@ SDL_Texture *load_texture(SDL_Surface *surface)
     if (surface == NULL)
         return NULL;
 
+    // Upload cached images directly from the mapped file, they are
+    // already in a format supported by the renderer
+    if (is_cached_surface(surface)) {
+        texture = SDL_CreateTexture(renderer,
+                      surface->format->format,
+                      SDL_TEXTUREACCESS_STATIC,
+                      surface->w,
+                      surface->h
+                  );
+        if (texture == NULL)
+            log_error("Could not create texture %s", SDL_GetError());
+        else
+            SDL_UpdateTexture(texture, NULL, surface->pixels, surface->pitch);
+        free_cached_surface(surface);
+        return texture;
+    }
+
     //Convert surface to screen format
     texture = SDL_CreateTextureFromSurface(renderer, surface);
     if (texture == NULL)
@@ -141,12 +712,27 @@ SDL_Texture *load_texture(SDL_Surface *surface)
     return texture;
 }
 
+// A function to get the amount of video memory used by a texture
+Sint64 get_texture_bytes(SDL_Texture *texture)
+{
+    Uint32 format;
+    int w, h;
+    if (texture == NULL || SDL_QueryTexture(texture, &format, NULL, &w, &h))
+        return 0;
+    return (Sint64) w * (Sint64) h * SDL_BYTESPERPIXEL(format);
+}
+
 // A function to rasterize an SVG from an existing text buffer
 SDL_Texture *rasterize_svg(char *buffer, int w, int h, SDL_Rect *rect)
+{
+    return load_texture(rasterize_svg_surface(buffer, w, h, rect));
+}
+
+// A function to rasterize an SVG from an existing text buffer to a surface
+SDL_Surface *rasterize_svg_surface(char *buffer, int w, int h, SDL_Rect *rect)
 {
     NSVGimage *image = NULL;
-    unsigned char *pixel_buffer = NULL;
-    int width, height, pitch;
+    int width, height;
     float scale;
 
     // Parse SVG to NSVGimage struct
@@ -179,31 +765,21 @@ SDL_Texture *rasterize_svg(char *buffer, int w, int h, SDL_Rect *rect)
     }
     
     // Allocate memory
-    pitch = 4*width;
-    pixel_buffer = malloc((size_t) (4*width*height));
-    if (pixel_buffer == NULL) {
+    SDL_Surface *surface = SDL_CreateRGBSurface(0, width, height, 32, COLOR_MASKS);
+    if (surface == NULL) {
         log_error("Could not alloc SVG pixel buffer.");
+        nsvgDelete(image);
         return NULL;
     }
 
     // Rasterize image
-    nsvgRasterize(rasterizer, image, 0, 0, scale, pixel_buffer, width, height, pitch);
-    SDL_Surface *surface = SDL_CreateRGBSurfaceFrom(pixel_buffer,
-                               width,
-                               height,
-                               32,
-                               pitch,
-                               COLOR_MASKS
-                           );
-    SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, surface);
+    nsvgRasterize(rasterizer, image, 0, 0, scale, surface->pixels, width, height, surface->pitch);
     if (rect != NULL) {
         rect->w = width;
         rect->h = height;
     }
-    free(pixel_buffer);
-    SDL_FreeSurface(surface);
     nsvgDelete(image);
-    return texture;
+    return surface;
 }
 
 // A function to render the highlight for the buttons
@@ -244,6 +820,24 @@ SDL_Texture *render_highlight(int width, int height, SDL_Rect *rect)
     return texture;
 }
 
+// A function to render the placeholder drawn for icons that are still loading
+SDL_Surface *render_placeholder(int size)
+{
+    char *buffer = NULL;
+    SDL_Color color = PLACEHOLDER_COLOR;
+    format_highlight(&buffer,
+        size,
+        size,
+        config.highlight_rx,
+        color,
+        PLACEHOLDER_OPACITY,
+        ""
+    );
+    SDL_Surface *surface = rasterize_svg_surface(buffer, -1, -1, NULL);
+    free(buffer);
+    return surface;
+}
+
 // A function to render the scroll indicators
 void render_scroll_indicators(Scroll *scroll, int height, Geometry *geo)
 {
@@ -258,10 +852,12 @@ void render_scroll_indicators(Scroll *scroll, int height, Geometry *geo)
     );
 
     // Rasterize the SVG
-    scroll->texture = rasterize_svg(buffer,
-                          -1,
-                          height,
-                          &scroll->rect_right
+    scroll->texture = track_texture(rasterize_svg(buffer,
+                                        -1,
+                                        height,
+                                        &scroll->rect_right
+                                    ),
+                          TEXTURE_INTERFACE
                       );
     free(buffer);
     scroll->rect_left.w = scroll->rect_right.w;
@@ -289,6 +885,7 @@ SDL_Surface *render_text(const char *text, TextInfo *info, SDL_Rect *rect, int *
 
     // Copy text into new buffer in case we need to manipulate it
     char *text_buffer = strdup(text);
+    SDL_LockMutex(text_mutex);
 
     // Calculate size of the rendered title
     TTF_SizeUTF8(info->font, text_buffer, &w, &h);
@@ -370,6 +967,7 @@ SDL_Surface *render_text(const char *text, TextInfo *info, SDL_Rect *rect, int *
     // Clean up
     if (reduced_font != NULL)
         TTF_CloseFont(reduced_font);
+    SDL_UnlockMutex(text_mutex);
     free(text_buffer);
     
     return surface;
@@ -3,6 +3,10 @@
 #define HIGHLIGHT_FORMAT "<svg viewBox=\"0 0 %i %i\"><rect x=\"0\" width=\"%i\" height=\"%i\" rx=\"%i\" fill=\"#%02X%02X%02X\" fill-opacity=\"%.2f\"%s/></svg>"
 #define SCROLL_INDICATOR_FORMAT "<svg width=\"195\" height=\"300\" viewBox=\"0 0 195 300\" version=\"1.1\" id=\"SVGRoot\" > <defs id=\"defs889\"/> <g id=\"layer1\" transform=\"translate(-105)\"> <path style=\"fill:#%02X%02X%02X;fill-opacity:%.2f;stroke:#%02X%02X%02X;stroke-width:%i;stroke-linecap:butt;stroke-linejoin:miter;stroke-miterlimit:4;stroke-dasharray:none;stroke-opacity:%.2f\" d=\"M 280,150 150,280 125,255 C 170,210 230.69212,149.36112 230,150 L 125,45 150,20 Z\" id=\"path3884\"/> </g></svg>"
 #define SHADOW_OPACITY_MULTIPLIER 0.75F
+#define PLACEHOLDER_COLOR {0xFF, 0xFF, 0xFF, 0xFF}
+#define PLACEHOLDER_OPACITY 0.15F
+#define IMAGE_HEADER_BYTES 32
+#define EXIF_TAG_ORIENTATION 0x0112
 
 // Macro functions
 #define format_highlight_outline(buffer, outline_size, outline_color, outline_opacity) sprintf_alloc(buffer, HIGHLIGHT_OUTLINE_FORMAT, outline_size, outline_color.r, outline_color.g, outline_color.b, outline_opacity)
@@ -24,13 +28,24 @@ typedef struct {
 int init_svg(void);
 int load_font(TextInfo *info, const char *default_font);
 void quit_svg(void);
+void init_text(void);
+void quit_text(void);
 void render_scroll_indicators(Scroll *scroll, int height, Geometry *geo);
-SDL_Surface *load_next_slideshow_background(Slideshow *slideshow, bool transition);
-int load_next_slideshow_background_async(void *data);
+bool read_image_info(const char *path, ImageInfo *info);
+SDL_Surface *load_background_surface(const char *path, int w, int h, Uint8 orientation);
+SDL_Surface *load_slideshow_surface(Slideshow *slideshow, int *attempts);
+SDL_Surface *check_slideshow_surface(Slideshow *slideshow, SDL_Surface *surface, int attempts);
+SDL_Surface *load_next_slideshow_background(Slideshow *slideshow);
+void load_next_slideshow_background_async(void *data);
 SDL_Texture *load_texture(SDL_Surface *surface);
 SDL_Texture *load_texture_from_file(const char *path);
+SDL_Surface *load_surface(const char *path);
+SDL_Surface *load_icon_surface(const char *path, int size);
+Sint64 get_texture_bytes(SDL_Texture *texture);
 SDL_Texture *rasterize_svg(char *buffer, int w, int h, SDL_Rect *rect);
+SDL_Surface *rasterize_svg_surface(char *buffer, int w, int h, SDL_Rect *rect);
 SDL_Texture *rasterize_svg_from_file(const char *path, int w, int h, SDL_Rect *rect);
 SDL_Texture *render_highlight(int width, int height, SDL_Rect *rect);
+SDL_Surface *render_placeholder(int size);
 SDL_Surface *render_text(const char *text, TextInfo *info, SDL_Rect *rect, int *text_height);
 SDL_Texture *render_text_texture(const char *text, TextInfo *info, SDL_Rect *rect, int *text_height);
@@ -15,6 +15,16 @@
 #include "util.h"
 #include "debug.h"
 #include "clock.h"
+#include "worker.h"
+#include "icons.h"
+#include "atlas.h"
+#include "directory.h"
+#include "search.h"
+#include "sources.h"
+#include "textures.h"
+#include "cache.h"
+#include "slideshow.h"
+#include "animation.h"
 #include "platform/platform.h"
 #include "video/video.h"
 
@@ -25,21 +35,77 @@ static void init_sdl_ttf(void);
 static int load_menu(Menu *menu, bool set_back_menu, bool reset_position);
 static int load_menu_by_name(const char *menu_name, bool set_back_menu, bool reset_position);
 static void update_slideshow(void);
+static void complete_slideshow_background(void *data, bool cancelled);
+static void show_slideshow_background(SDL_Texture *texture);
+static void finish_slideshow_transition(void);
+static void complete_slideshow_transition(void *data);
+static void complete_screensaver_transition(void *data);
+static void push_slideshow_history(SDL_Texture *texture);
+static void init_pan_zoom(PanZoom *motion);
+static void render_pan_zoom(SDL_Texture *texture, PanZoom *motion);
+static void next_slideshow_background(void);
+static void previous_slideshow_background(void);
 static void resume_slideshow(void);
 static void update_screensaver(void);
 static void update_clock(bool block);
+static void complete_clock(void *data, bool cancelled);
 static void init_slideshow(void);
 static void init_screensaver(void);
-static void calculate_button_geometry(Entry *entry, int buttons);
-static void render_buttons(Menu *menu);
+static unsigned int get_current_position(void);
+static Entry *get_current_entry(void);
+static EntryInfo *get_current_entry_info(void);
+static Menu *get_shown_menu(void);
+static int get_home_row(Menu *menu);
+static bool menu_visible(Menu *menu);
+static unsigned int get_layout_rows(void);
+static void scroll_to_row(MenuRows *rows);
+static void refresh_menu(void);
+static void layout_home(void);
+static void cancel_menu(Menu *menu);
+static void calculate_button_geometry(Menu *menu);
+static void load_entries(Menu *menu);
+static void reload_shown_menus(void);
+static void set_load_range(Menu *menu, unsigned int start, unsigned int end);
+static void queue_entries(Menu *menu, unsigned int start, unsigned int end, JobPriority priority);
+static Menu *get_submenu(EntryInfo *info);
+static void update_prefetch(void);
+static void evict_menus(void);
+static void cancel_entries(Menu *menu);
+static void unload_entry(Entry *entry);
+static void load_entry_async(void *data);
+static void complete_entry(void *data, bool cancelled);
+static void select_entry(unsigned int position);
+static void scroll_page(unsigned int page, bool forward);
+static float get_page_offset(Menu *menu);
+static unsigned int get_scroll_rows(void);
 static void move_left(void);
 static void move_right(void);
+static void move_up(void);
+static void move_down(void);
+static void select_row(unsigned int position);
+static void move_highlight(Entry *entry, bool animate);
 static void load_submenu(const char *submenu);
 static void load_back_menu(Menu *menu);
+static void select_current_entry(void);
+static void start_search(void);
+static void end_search(void);
+static void update_search_results(void);
+static void handle_text_input(const char *text);
+static void erase_search_character(void);
+static void update_source_text(void);
+static void refresh_titles(Menu *menu, Uint32 since);
+static void render_status(void);
+static void batch_entries(Menu *menu, unsigned int page, float x_offset, bool titles);
 static void draw_screen(void);
 static void handle_keypress(SDL_Keysym *key);
 static void execute_command(const char *command);
 static void poll_gamepad(void);
+static bool gamepad_pressed(void);
+static bool screen_animating(void);
+static void limit_timeout(int *timeout, int milliseconds);
+static int get_time_until(Uint32 deadline);
+static int get_idle_timeout(void);
+static void wait_for_event(int timeout);
 static void init_gamepad(Gamepad **gamepad, int device_index);
 static void connect_gamepad(int device_index, bool open, bool raise_error);
 static void disconnect_gamepad(int id, bool disconnect, bool remove);
@@ -81,6 +147,7 @@ Config config = {
     .background_overlay_color.b       = DEFAULT_BACKGROUND_OVERLAY_COLOR_B,
     .background_overlay_color.a       = DEFAULT_BACKGROUND_OVERLAY_COLOR_A,
     .background_overlay_opacity[0]    = '\0',
+    .image_cache_size                 = DEFAULT_IMAGE_CACHE_SIZE,
     .highlight                        = true,
     .icon_size                        = DEFAULT_ICON_SIZE,
     .highlight_fill_color.r           = DEFAULT_HIGHLIGHT_FILL_COLOR_R,
@@ -95,6 +162,7 @@ Config config = {
     .highlight_rx                     = DEFAULT_HIGHLIGHT_CORNER_RADIUS,
     .title_padding                    = -1,
     .max_buttons                      = DEFAULT_MAX_BUTTONS,
+    .rows                             = DEFAULT_ROWS,
     .icon_spacing                     = -1,
     .highlight_vpadding               = -1,
     .highlight_hpadding               = -1,
@@ -117,6 +185,8 @@ Config config = {
     .title_oversize_mode              = OVERSIZE_TRUNCATE,
     .wrap_entries                     = DEFAULT_WRAP_ENTRIES,
     .reset_on_back                    = DEFAULT_RESET_ON_BACK,
+    .prefetch_size                    = DEFAULT_PREFETCH_SIZE,
+    .texture_budget                   = DEFAULT_TEXTURE_BUDGET,
     .mouse_select                     = DEFAULT_MOUSE_SELECT,
     .inhibit_os_screensaver           = DEFAULT_INHIBIT_OS_SCREENSAVER,
     .startup_cmd                      = NULL,
@@ -153,12 +223,17 @@ Config config = {
     .clock_time_format                = DEFAULT_CLOCK_TIME_FORMAT,
     .clock_date_format                = DEFAULT_CLOCK_DATE_FORMAT,
     .clock_include_weekday            = DEFAULT_CLOCK_INCLUDE_WEEKDAY,
+    .status_enabled                   = DEFAULT_STATUS_ENABLED,
+    .status_text                      = NULL,
+    .status_alignment                 = DEFAULT_STATUS_ALIGNMENT,
     .slideshow_image_duration         = DEFAULT_SLIDESHOW_IMAGE_DURATION,
-    .slideshow_transition_time        = DEFAULT_SLIDESHOW_TRANSITION_TIME
+    .slideshow_transition_time        = DEFAULT_SLIDESHOW_TRANSITION_TIME,
+    .slideshow_history_size           = DEFAULT_SLIDESHOW_HISTORY_SIZE,
+    .slideshow_pan_zoom               = DEFAULT_SLIDESHOW_PAN_ZOOM
 };
 
 // Initialize default states
-State state = { false };
+State state = { .redraw = true };
 
 // Global variables
 SDL_Window *window                    = NULL;
@@ -167,8 +242,10 @@ SDL_Texture *background_texture       = NULL;
 SDL_Texture *background_overlay       = NULL;
 Menu *default_menu                    = NULL;
 Menu *current_menu                    = NULL;
-Entry *current_entry                  = NULL;
+Menu *home_menu                       = NULL;
 Highlight *highlight                  = NULL;
+AtlasRegion placeholder;
+PageScroll page_scroll                = {0};
 Scroll *scroll                        = NULL;
 Slideshow *slideshow                  = NULL;
 Screensaver *screensaver              = NULL;
@@ -177,9 +254,11 @@ Gamepad *gamepads                     = NULL;
 GamepadControl *gamepad_controls      = NULL;
 Hotkey *hotkeys                       = NULL;
 Clock *clk                            = NULL;
+Search *search                        = NULL;
+Status *status                        = NULL;
+Uint32 sources_version                = 0; // Sources version of the rendered titles and status
+Menu *prefetch_menu                   = NULL;
 TTF_Font *clock_font                  = NULL;
-SDL_Thread *Slideshowhread            = NULL;
-SDL_Thread *clock_thread              = NULL;
 SDL_Event event;
 SDL_SysWMinfo wm_info;
 SDL_DisplayMode display_mode;
@@ -250,8 +329,6 @@ static void create_window()
         if (!repeat_period)
             repeat_period = 1;
     }
-    if (slideshow != NULL)
-        slideshow->transition_change_rate = 255.0f / ((float) config.slideshow_transition_time / (float) refresh_period);
 
     renderer = SDL_CreateRenderer(window, -1, renderer_flags);
     SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
@@ -281,8 +358,20 @@ static void init_sdl_image()
 void set_draw_color()
 {
     SDL_Color *color = NULL;
-    if (config.background_mode == BACKGROUND_COLOR)
+    SDL_Color blended;
+    if (config.background_mode == BACKGROUND_COLOR) {
         color = &config.background_color;
+
+        // Blend the overlay into the background color
+        if (config.background_overlay) {
+            SDL_Color *overlay = &config.background_overlay_color;
+            blended.r = (Uint8) ((color->r * (0xFF - overlay->a) + overlay->r * overlay->a + 127) / 0xFF);
+            blended.g = (Uint8) ((color->g * (0xFF - overlay->a) + overlay->g * overlay->a + 127) / 0xFF);
+            blended.b = (Uint8) ((color->b * (0xFF - overlay->a) + overlay->b * overlay->a + 127) / 0xFF);
+            blended.a = color->a;
+            color = &blended;
+        }
+    }
     else if (config.background_mode == BACKGROUND_TRANSPARENT)
         color = &config.chroma_key_color;
 
@@ -302,6 +391,7 @@ static void init_sdl_ttf()
 {
     if (TTF_Init() == -1)
         log_fatal("Could not initialize SDL_ttf\n%s", TTF_GetError());
+    init_text();
     
     title_info = (TextInfo) { 
         .font_size = (int) config.title_font_size,
@@ -328,9 +418,8 @@ static void init_sdl_ttf()
 static void cleanup()
 {
     cleanup_video();
-    // Wait until all threads have completed
-    SDL_WaitThread(Slideshowhread, NULL);
-    SDL_WaitThread(clock_thread, NULL);
+    // Wait until all running jobs have completed
+    quit_workers();
     
     // Destroy renderer and window
     if (renderer != NULL) {
@@ -346,9 +435,12 @@ static void cleanup()
     SDL_Quit();
     IMG_Quit();
     TTF_Quit();
+    quit_text();
     quit_svg();
+    quit_image_cache();
     if (config.background_mode == BACKGROUND_SLIDESHOW)
         quit_slideshow();
+    quit_textures();
 
     // Close log file if open
     if (log_file != NULL)
@@ -368,28 +460,24 @@ static void cleanup()
     free(scroll);
     free(screensaver);
     free(clk);
-
-    // Free menu and entry linked lists
-    Entry *entry = NULL;
-    Entry *tmp_entry = NULL;
+    free(search);
+    free(status);
+    free(config.status_text);
+    quit_sources();
+
+    // Free menu linked list and entry arrays
+    quit_search();
+    quit_directory_menus();
     Menu *menu = config.first_menu;
     Menu *tmp_menu = NULL;
     for (size_t i = 0; i < config.num_menus; i++) {
-        free(menu->name);
-        entry = menu->first_entry;
-        for(size_t j = 0; j < menu->num_entries; j++) {
-            free(entry->title);
-            free(entry->icon_path);
-            free(entry->icon_selected_path);
-            free(entry->cmd);
-            tmp_entry = entry;
-            entry = entry->next;
-            free(tmp_entry);
-        }
         tmp_menu = menu;
         menu = menu->next;
-        free(tmp_menu);
+        free_menu(tmp_menu);
     }
+    free_menu_index();
+    quit_icon_cache();
+    quit_atlas();
 
     // Free hotkey linked list
     Hotkey *tmp_hotkey = NULL;
@@ -424,20 +512,24 @@ static void handle_keypress(SDL_Keysym *key)
         move_left();
     else if (key->sym == SDLK_RIGHT)
         move_right();
-    else if (key->sym == SDLK_RETURN) {
-        log_debug("Selected Entry:\n"
-            "Title: %s\n"
-            "Icon Path: %s\n"
-            "Command: %s", 
-            current_entry->title, 
-            current_entry->icon_path, 
-            current_entry->cmd
-        );
-        
-        execute_command(current_entry->cmd);
+    else if (key->sym == SDLK_UP && (config.rows > 1 || home_menu != NULL))
+        move_up();
+    else if (key->sym == SDLK_DOWN && (config.rows > 1 || home_menu != NULL))
+        move_down();
+    else if (key->sym == SDLK_RETURN)
+        select_current_entry();
+    else if (key->sym == SDLK_BACKSPACE) {
+        if (state.searching)
+            erase_search_character();
+        else
+            load_back_menu(get_shown_menu());
+    }
+
+    // Other keys type the search query, Esc ends the search
+    else if (state.searching) {
+        if (key->sym == SDLK_ESCAPE)
+            end_search();
     }
-    else if (key->sym == SDLK_BACKSPACE)
-        load_back_menu(current_menu);
 
     //Check hotkeys
     else {
@@ -453,12 +545,22 @@ static void handle_keypress(SDL_Keysym *key)
 // A function to quit the slideshow mode in case of error or program exit
 void quit_slideshow()
 {
-    // Free allocated image paths
-    for (int i = 0; i < slideshow->num_images; i++)
-        free(slideshow->images[i]);
-    free(slideshow->images);
-    free(slideshow->order);
+    // Stop monitoring the directory, free allocated image paths
+    quit_slideshow_images(slideshow);
+    stop_animation(&slideshow->transition);
+
+    // Free the resident textures, unless they were already
+    // destroyed together with the renderer
+    if (renderer != NULL) {
+        for (int i = 0; i < slideshow->history_length; i++) {
+            if (slideshow->history[i] == background_texture)
+                background_texture = NULL;
+            destroy_texture(slideshow->history[i]);
+        }
+        destroy_texture(slideshow->next_texture);
+    }
     free(slideshow);
+    slideshow = NULL;
 }
 
 // A function to initialize the slideshow background mode
@@ -478,19 +580,37 @@ static void init_slideshow()
     *slideshow = (Slideshow) {
         .i = -1,
         .num_images = 0,
+        .num_available = 0,
+        .max_images = 0,
+        .scan_thread = NULL,
+        .num_probe_threads = 0,
+        .probe_queue = NULL,
+        .num_probes = 0,
+        .max_probes = 0,
+        .num_pending = 0,
+        .index_modified = false,
         .transition_surface = NULL,
+        .load_attempts = 0,
         .transition_texture = NULL,
         .transition_alpha = 0.f,
-        .transition_change_rate = 0.f,
+        .next_texture = NULL,
+        .history_length = 0,
+        .history_position = -1,
+        .texture_bytes = 0,
+        .motion_random_state = SDL_GetPerformanceCounter(),
         .images = NULL,
-        .order = NULL
+        .paths = { NULL },
+        .free_images = NULL,
+        .num_free_images = 0,
+        .max_free_images = 0
     };
 
-    // Find background images from directory
-    scan_slideshow_directory(slideshow, config.slideshow_directory);
+    // Find background images from directory, the scan continues in
+    // the background once enough images are found to start
+    init_slideshow_images(slideshow);
     
     // Handle errors
-    if (!slideshow->num_images) {
+    if (!slideshow->num_available) {
         log_error("No images found in slideshow directory '%s', "
             "Changing background mode to color", 
             config.slideshow_directory
@@ -498,24 +618,19 @@ static void init_slideshow()
         config.background_mode = BACKGROUND_COLOR;
         quit_slideshow();
     } 
-    else if (slideshow->num_images == 1) {
+    else if (slideshow->num_available == 1) {
         log_error("Only one image found in slideshow directory %s"
             "Changing background mode to single image", 
             config.slideshow_directory
         );
         free(config.background_image);
-        config.background_image = strdup(slideshow->images[0]);
+        config.background_image = get_next_slideshow_image(slideshow, NULL);
         config.background_mode = BACKGROUND_IMAGE;
         quit_slideshow();
     }
 
-    // Generate array of random numbers for image order, load first image
-    else {
-        slideshow->order = malloc(sizeof(int) * (size_t) slideshow->num_images);
-        random_array(slideshow->order, slideshow->num_images);
-        if (config.debug)
-            debug_slideshow(slideshow);
-    }
+    else if (config.debug)
+        debug_slideshow(slideshow);
 }
 
 // A function to initialize the screensaver feature
@@ -546,7 +661,7 @@ static void init_screensaver()
     else if (screensaver->alpha_end_value >= 255.0f)
         screensaver->alpha_end_value = 255.0f;
 
-    screensaver->transition_change_rate = screensaver->alpha_end_value / ((float) SCREENSAVER_TRANSITION_TIME / (float) refresh_period);
+    screensaver->transition.active = false;
     
     // Render texture
     SDL_Surface *surface = NULL;
@@ -558,7 +673,7 @@ static void init_screensaver()
               );
     Uint32 color = SDL_MapRGBA(surface->format, 0, 0, 0, 0xFF);
     SDL_FillRect(surface, NULL, color);
-    screensaver->texture = load_texture(surface);
+    screensaver->texture = track_texture(load_texture(surface), TEXTURE_INTERFACE);
     screensaver->alpha = 0.0f;
     SDL_SetTextureAlphaMod(screensaver->texture, 0.0f);
 }
@@ -575,46 +690,72 @@ static int load_menu(Menu *menu, bool set_back_menu, bool reset_position)
     if (menu == NULL)
         return 1;
 
-    unsigned int buttons;
-    Menu *previous_menu = current_menu;
-
-    current_menu = menu;
-    log_debug("Loading menu '%s'", current_menu->name);
+    Menu *previous_menu = get_shown_menu();
+    log_debug("Loading menu '%s'", menu->name);
+
+    // The highlight of a menu with rows is in one of the menus of its rows,
+    // skip to the next row with entries if a directory scan emptied it. Empty
+    // rows get their entries once their scans find files, a row that is still
+    // being scanned is shown if no row has entries yet.
+    Menu *focused_menu = menu;
+    if (menu->rows != NULL) {
+        MenuRows *rows = menu->rows;
+        if (reset_position) {
+            rows->position = 0;
+            rows->first = 0;
+        }
+        bool found = false;
+        for (int scanning = 0; scanning < 2 && !found; scanning++) {
+            for (unsigned int i = 0; i < rows->num_rows && !found; i++) {
+                Menu *row = rows->menus[rows->position];
+                found = row->num_entries > 0 || (scanning && directory_menu_scanning(row));
+                if (!found)
+                    rows->position = (rows->position + 1) % rows->num_rows;
+            }
+        }
+        scroll_to_row(rows);
+        focused_menu = rows->num_rows ? rows->menus[rows->position] : NULL;
+    }
 
-    // Return error if the menu doesn't contain entires
-    if (current_menu->num_entries == 0) {
-        log_error("No valid entries found for Menu '%s'", current_menu->name);
-        current_menu = previous_menu;
+    // Return error if the menu doesn't contain entires, a directory menu
+    // is shown without entries while its scan may still find files
+    if (focused_menu == NULL ||
+    (focused_menu->num_entries == 0 && !directory_menu_scanning(focused_menu))) {
+        log_error("No valid entries found for Menu '%s'", menu->name);
         return 1;
     }
 
-    // Render the menu if not already rendered
-    if (current_menu->rendered == false)
-        render_buttons(current_menu);
+    // Stop loading the previous menu
+    if (previous_menu != NULL && previous_menu != menu)
+        cancel_menu(previous_menu);
+    home_menu = menu->rows != NULL ? menu : NULL;
+    current_menu = focused_menu;
+
+    // Requeue the prefetch of the menu with the priority of visible entries,
+    // the completions of the cancelled jobs submit them again
+    if (current_menu == prefetch_menu) {
+        cancel_entries(current_menu);
+        prefetch_menu = NULL;
+    }
 
     // Set menu properties
     if (set_back_menu)
-        current_menu->back = previous_menu;
+        menu->back = previous_menu;
 
     if (reset_position) {
-        current_entry = current_menu->first_entry;
-        current_menu->root_entry = current_entry;
-        current_menu->highlight_position = 0;
-        current_menu->page = 0;
+        unsigned int num_menus = home_menu != NULL ? home_menu->rows->num_rows : 1;
+        Menu **menus = home_menu != NULL ? home_menu->rows->menus : &current_menu;
+        for (unsigned int i = 0; i < num_menus; i++) {
+            menus[i]->highlight_position = 0;
+            menus[i]->page = 0;
+        }
     }
-    else
-        current_entry = current_menu->last_selected_entry;
 
-    buttons = current_menu->num_entries - (current_menu->page)*config.max_buttons;
-    if (buttons > config.max_buttons)
-        buttons = config.max_buttons;
-    
-    // Recalculate the screen geometry
-    calculate_button_geometry(current_menu->root_entry, (int) buttons);
-    if (config.highlight) {
-        highlight->rect.x = current_entry->icon_rect.x - config.highlight_hpadding;
-        highlight->rect.y = current_entry->icon_rect.y - config.highlight_vpadding;
-    }
+    // Recalculate the screen geometry, load the icons of the visible entries first
+    menu->last_visit = ticks.main;
+    current_menu->last_visit = ticks.main;
+    refresh_menu();
+    log_texture_usage();
     return 0;
 }
 
@@ -625,130 +766,595 @@ static int load_menu_by_name(const char *menu_name, bool set_back_menu, bool res
     return load_menu(menu, set_back_menu, reset_position);
 }
 
-// A function to calculate the layout of the buttons
-static void calculate_button_geometry(Entry *entry, int buttons)
+// A function to get the position of the selected entry in the current menu
+static unsigned int get_current_position()
+{
+    return current_menu->page*config.max_buttons + current_menu->highlight_position;
+}
+
+// A function to get the selected entry of the current menu
+static Entry *get_current_entry()
+{
+    return current_menu->entries + get_current_position();
+}
+
+// A function to get the strings of the selected entry of the current menu
+static EntryInfo *get_current_entry_info()
+{
+    return current_menu->entry_info + get_current_position();
+}
+
+// A function to get the menu that is shown, the menu with rows
+// if the home screen is shown
+static Menu *get_shown_menu()
+{
+    return home_menu != NULL ? home_menu : current_menu;
+}
+
+// A function to get the row of the screen a menu is shown in on the
+// home screen, -1 if the menu isn't one of the visible rows
+static int get_home_row(Menu *menu)
+{
+    if (home_menu == NULL)
+        return -1;
+    MenuRows *rows = home_menu->rows;
+    unsigned int end = MIN(rows->first + config.rows, rows->num_rows);
+    for (unsigned int i = rows->first; i < end; i++) {
+        if (rows->menus[i] == menu)
+            return (int) (i - rows->first);
+    }
+    return -1;
+}
+
+// A function to determine if the entries of a menu are on screen
+static bool menu_visible(Menu *menu)
+{
+    return menu == current_menu || get_home_row(menu) >= 0;
+}
+
+// A function to get the number of rows of entries a menu is laid out in,
+// each menu of the home screen is a single row
+static unsigned int get_layout_rows()
+{
+    return home_menu != NULL ? 1 : config.rows;
+}
+
+// A function to scroll the rows of the home screen so the selected row is visible
+static void scroll_to_row(MenuRows *rows)
+{
+    if (rows->position < rows->first)
+        rows->first = rows->position;
+    else if (rows->position >= rows->first + config.rows)
+        rows->first = rows->position - config.rows + 1;
+}
+
+// A function to lay out the shown menu and load its visible entries
+static void refresh_menu()
+{
+    stop_animation(&page_scroll.animation);
+    if (home_menu != NULL)
+        layout_home();
+    else {
+        calculate_button_geometry(current_menu);
+        load_entries(current_menu);
+    }
+    if (config.highlight && current_menu->num_entries)
+        move_highlight(get_current_entry(), false);
+}
+
+// A function to lay out the visible rows of the home screen and load their
+// entries. The rows next to the visible ones are loaded in the background,
+// the other rows are unloaded so only the rows near the screen use memory.
+static void layout_home()
+{
+    MenuRows *rows = home_menu->rows;
+    unsigned int start = rows->first > 0 ? rows->first - 1 : 0;
+    unsigned int end = MIN(rows->first + config.rows + 1, rows->num_rows);
+    for (unsigned int i = 0; i < rows->num_rows; i++) {
+        Menu *menu = rows->menus[i];
+        if (i >= rows->first && i < rows->first + config.rows) {
+            menu->last_visit = ticks.main;
+            calculate_button_geometry(menu);
+        }
+        if (i >= start && i < end)
+            load_entries(menu);
+        else if (menu != prefetch_menu)
+            set_load_range(menu, 0, 0);
+    }
+}
+
+// A function to cancel the pending loads of a menu or of the menus of its rows
+static void cancel_menu(Menu *menu)
+{
+    if (menu->rows == NULL) {
+        cancel_entries(menu);
+        return;
+    }
+    for (unsigned int i = 0; i < menu->rows->num_rows; i++)
+        cancel_entries(menu->rows->menus[i]);
+}
+
+// A function to calculate the layout of the visible buttons, a single row
+// is centered on the screen while the columns of a grid stay in place.
+// The menus of the home screen are laid out below each other.
+static void calculate_button_geometry(Menu *menu)
 {
     // Calculate proper spacing
-    geo.x_margin = (geo.screen_width - config.icon_size*buttons -
-                   buttons*config.icon_spacing + config.icon_spacing) / 2;
+    int row = get_home_row(menu);
+    unsigned int first = menu->page*config.max_buttons;
+    int buttons = (int) MIN(get_layout_rows()*config.max_buttons, menu->num_entries - first);
+    int columns = config.rows > 1 && home_menu == NULL ? (int) config.max_buttons : buttons;
+    int x_margin = (geo.screen_width - config.icon_size*columns -
+                   columns*config.icon_spacing + config.icon_spacing) / 2;
+    int y_margin = geo.y_margin + (row > 0 ? row*geo.y_advance : 0);
     geo.x_advance = config.icon_size + config.icon_spacing;
-    geo.num_buttons = buttons;
+    if (menu == current_menu) {
+        geo.x_margin = x_margin;
+        geo.num_buttons = buttons;
+    }
 
     // Assign values to entries
-    for (int i = 0; i < geo.num_buttons; i++) {
-            entry->icon_rect.x = geo.x_margin + i*geo.x_advance;
-            entry->icon_rect.y = geo.y_margin;
+    Entry *entry = menu->entries + first;
+    for (int i = 0; i < buttons; i++, entry++) {
+            entry->icon_rect.x = x_margin + (i % (int) config.max_buttons)*geo.x_advance;
+            entry->icon_rect.y = y_margin + (i / (int) config.max_buttons)*geo.y_advance;
             entry->icon_rect.w = config.icon_size;
             entry->icon_rect.h = config.icon_size;
             entry->text_rect.x = entry->icon_rect.x +
                                  (entry->icon_rect.w - entry->text_rect.w) / 2;
             entry->text_rect.y = entry->icon_rect.y + config.icon_size + entry->title_offset + 
                                  config.title_padding;
-            entry = entry->next;
     }
 }
 
-// A function to render all buttons (icon and text) for a menu
-static void render_buttons(Menu *menu)
+// A function to queue the icons and titles of a menu for loading in worker
+// threads, the visible entries first and then the rows next to them. The
+// menus of the home screen rows next to the screen are loaded in the background.
+static void load_entries(Menu *menu)
 {
-    Entry *entry;
-    int h;
-    for (entry = menu->first_entry; entry != NULL; entry = entry->next) {
-        entry->icon = load_texture_from_file(entry->icon_path);
-        entry->icon_selected = (entry->icon_selected_path != NULL) ? load_texture_from_file(entry->icon_selected_path) : NULL;
-        if (config.titles_enabled) {
-            entry->title_texture = render_text_texture(entry->title, &title_info, &entry->text_rect, &h);
-            if (config.title_oversize_mode == OVERSIZE_SHRINK && h != geo.font_height)
-                entry->title_offset = (geo.font_height - h) / 2;
-        }
-    }
-    menu->rendered = true;
+    unsigned int first = menu->page*config.max_buttons;
+    unsigned int last = MIN(first + get_layout_rows()*config.max_buttons, menu->num_entries);
+    unsigned int margin = PREFETCH_ROWS*config.max_buttons;
+    unsigned int start = first > margin ? first - margin : 0;
+    unsigned int end = MIN(last + margin, menu->num_entries);
+    set_load_range(menu, start, end);
+    queue_entries(menu, first, last, menu_visible(menu) ? PRIORITY_INTERACTIVE : PRIORITY_BACKGROUND);
+    queue_entries(menu, start, first, PRIORITY_BACKGROUND);
+    queue_entries(menu, last, end, PRIORITY_BACKGROUND);
 }
 
-// A function to move the selection left when clicked by user
-static void move_left()
+// A function to queue the entries of the shown menus that aren't loaded,
+// including the home screen rows next to the screen
+static void reload_shown_menus()
 {
-    // If we are not in leftmost position, move highlight left
-    if (current_menu->highlight_position > 0) {
-        if (config.highlight)
-            highlight->rect.x -= geo.x_advance;
-        current_menu->highlight_position--;
-        current_entry = current_entry->previous;
+    if (home_menu == NULL) {
+        load_entries(current_menu);
+        return;
+    }
+    MenuRows *rows = home_menu->rows;
+    for (unsigned int i = 0; i < rows->num_rows; i++) {
+        if (rows->menus[i]->load_start != rows->menus[i]->load_end)
+            load_entries(rows->menus[i]);
     }
+}
 
-    // If we are in leftmost position...
-    else if (current_menu->highlight_position == 0 && (current_menu->page > 0 || config.wrap_entries)) {
-        unsigned int buttons;
-        current_entry = current_entry->previous;
+// A function to set the range of entries of a menu that are kept loaded.
+// Entries that are no longer in range are cancelled or unloaded, so the
+// memory used doesn't depend on the number of entries in the menu.
+static void set_load_range(Menu *menu, unsigned int start, unsigned int end)
+{
+    for (unsigned int i = menu->load_start; i < menu->load_end; i++) {
+        if (i >= start && i < end)
+            continue;
+        if (menu->entries[i].job != NULL)
+            cancel_job(menu->entries[i].job);
+        else
+            unload_entry(menu->entries + i);
+    }
+    menu->load_start = start;
+    menu->load_end = end;
+}
 
-        // Load the previous page if there is a valid previous entry
-        if (current_entry) {
-            buttons = config.max_buttons;
-            current_menu->root_entry = advance_entries(current_menu->root_entry, (int) buttons, DIRECTION_LEFT);
-            current_menu->page--;
+// A function to submit jobs for the entries of a menu that aren't loaded yet
+static void queue_entries(Menu *menu, unsigned int start, unsigned int end, JobPriority priority)
+{
+    for (unsigned int i = start; i < end; i++) {
+        Entry *entry = menu->entries + i;
+        EntryInfo *info = menu->entry_info + i;
+        if (entry->job != NULL)
+            continue;
+        if (entry->icon == NULL) {
+            entry->icon = acquire_icon(info->icon_path, config.icon_size);
+            entry->icon_selected = acquire_icon(info->icon_selected_path, config.icon_size);
         }
 
-        // If the user has the wrap entries setting, select the last entry in the menu
-        else {
-            current_entry = advance_entries(current_menu->first_entry, (int) current_menu->num_entries - 1, DIRECTION_RIGHT);
-            unsigned int num_pages = DIV_ROUND_UP(current_menu->num_entries, config.max_buttons);
-            current_menu->root_entry = advance_entries(current_menu->root_entry,
-                (int) ((num_pages - 1 - current_menu->page) * config.max_buttons),
-                DIRECTION_RIGHT
-            );
-            current_menu->page = num_pages - 1;
-            buttons = current_menu->num_entries - current_menu->page * config.max_buttons;
+        // Icons shared with other entries are only loaded once
+        bool load_icon = icon_needs_loading(entry->icon);
+        bool load_icon_selected = icon_needs_loading(entry->icon_selected);
+        if (entry->loaded && !load_icon && !load_icon_selected)
+            continue;
+        char *source_title = !entry->loaded && has_sources(info->title) ? expand_sources(info->title) : NULL;
+        EntryLoad *load = malloc(sizeof(EntryLoad));
+        *load = (EntryLoad) {
+            .menu = menu,
+            .index = i,
+            .title_text = source_title != NULL ? source_title : info->title,
+            .source_title = source_title,
+            .sources_version = get_sources_version(),
+            .icon = load_icon ? entry->icon : NULL,
+            .icon_selected = load_icon_selected ? entry->icon_selected : NULL,
+            .icon_surface = NULL,
+            .icon_selected_surface = NULL,
+            .render_title = !entry->loaded,
+            .title = NULL,
+            .title_height = geo.font_height,
+            .done = false
+        };
+        if (load_icon)
+            entry->icon->loader = entry;
+        if (load_icon_selected)
+            entry->icon_selected->loader = entry;
+        entry->job = submit_job(priority, load_entry_async, complete_entry, (void*) load);
+        menu->num_jobs++;
+    }
+}
+
+// A function to find the menu an entry opens, NULL if it doesn't open one
+static Menu *get_submenu(EntryInfo *info)
+{
+    size_t length = strlen(SCMD_SUBMENU);
+    if (strncmp(info->cmd, SCMD_SUBMENU, length) || info->cmd[length] != ' ')
+        return NULL;
+    return find_menu(info->cmd + length + 1);
+}
+
+// A function to prefetch the first page of the submenu the selected entry
+// opens, so it is shown without placeholders if the entry is selected. The
+// prefetch only runs when the workers are idle, it is dropped when the highlight
+// moves to another entry and limited to the prefetch size setting.
+static void update_prefetch()
+{
+    Menu *menu = NULL;
+    if (config.prefetch_size && current_menu->num_entries)
+        menu = get_submenu(get_current_entry_info());
+    if (menu != NULL && (menu_visible(menu) || menu->num_entries == 0))
+        menu = NULL;
+    if (menu == prefetch_menu)
+        return;
+    if (prefetch_menu != NULL)
+        set_load_range(prefetch_menu, 0, 0);
+    prefetch_menu = menu;
+    if (menu == NULL)
+        return;
+
+    // An entry uses an icon, a selected icon and a title
+    size_t entry_bytes = 4 * (size_t) config.icon_size * (size_t) (2*config.icon_size + geo.font_height);
+    size_t max_entries = (size_t) config.prefetch_size * BYTES_PER_MEGABYTE / entry_bytes;
+    unsigned int end = MIN(config.rows*config.max_buttons, menu->num_entries);
+    end = (unsigned int) MIN((size_t) end, max_entries);
+    set_load_range(menu, 0, end);
+    queue_entries(menu, 0, end, PRIORITY_IDLE);
+}
+
+// A function to unload the least recently shown menus until the icons and
+// titles of the menus fit in the budget, they are loaded again when the menu
+// is shown. The visible and the prefetched menus are kept.
+static void evict_menus()
+{
+    while (texture_budget_exceeded()) {
+        Menu *oldest = NULL;
+        Menu *menu = config.first_menu;
+        for (size_t i = 0; i < config.num_menus; i++, menu = menu->next) {
+            if (menu_visible(menu) || menu == prefetch_menu || menu->load_start == menu->load_end)
+                continue;
+            if (oldest == NULL || menu->last_visit < oldest->last_visit)
+                oldest = menu;
         }
+        if (oldest == NULL)
+            return;
+        log_debug("Unloading menu '%s' to stay within the texture budget", oldest->name);
+        Sint64 usage = get_menu_texture_usage();
+        set_load_range(oldest, 0, 0);
+        log_texture_usage();
+
+        // Icons shared with the menus that stay loaded are not freed,
+        // unloading more menus would not get within the budget either
+        if (get_menu_texture_usage() >= usage)
+            return;
+    }
+}
 
-        calculate_button_geometry(current_menu->root_entry, (int) buttons);
-        if (config.highlight)
-            highlight->rect.x = current_entry->icon_rect.x - config.highlight_hpadding;
-        current_menu->highlight_position = buttons - 1;
+// A function to cancel all pending loads of a menu, the loaded
+// entries are kept for when the menu is shown again
+static void cancel_entries(Menu *menu)
+{
+    for (unsigned int i = menu->load_start; i < menu->load_end; i++) {
+        if (menu->entries[i].job != NULL)
+            cancel_job(menu->entries[i].job);
+    }
+}
+
+// A function to free the icons and title of an entry that is out of range
+static void unload_entry(Entry *entry)
+{
+    release_icon(entry->icon);
+    release_icon(entry->icon_selected);
+    entry->icon = NULL;
+    entry->icon_selected = NULL;
+    free_atlas_region(&entry->title_region);
+    entry->title_offset = 0;
+    entry->loaded = false;
+}
+
+// A function to load the icons and title of an entry in a worker thread
+static void load_entry_async(void *data)
+{
+    EntryLoad *load = (EntryLoad*) data;
+    if (load->icon != NULL)
+        load->icon_surface = load_icon_surface(load->icon->path, load->icon->size);
+    if (load->icon_selected != NULL)
+        load->icon_selected_surface = load_icon_surface(load->icon_selected->path, load->icon_selected->size);
+    if (load->render_title && config.titles_enabled)
+        load->title = render_text(load->title_text, &title_info, &load->text_rect, &load->title_height);
+    load->done = true;
+}
+
+// A function to convert the loaded icons and title of an entry to textures
+static void complete_entry(void *data, bool cancelled)
+{
+    (void) cancelled;
+    EntryLoad *load = (EntryLoad*) data;
+    Entry *entry = load->menu->entries + load->index;
+    entry->job = NULL;
+    load->menu->num_jobs--;
+    bool shared = false;
+    if (load->icon != NULL) {
+        load->icon->loader = NULL;
+        shared = load->icon->references > 1;
+    }
+    if (load->icon_selected != NULL) {
+        load->icon_selected->loader = NULL;
+        shared = shared || load->icon_selected->references > 1;
+    }
+
+    // Keep the result of a job that was cancelled while it was running,
+    // the menu is requeued if a job was cancelled before it could run.
+    // Entries of other menus that share an icon skipped it while this job
+    // was loading it, so all shown menus are requeued.
+    bool in_range = load->index >= load->menu->load_start && load->index < load->menu->load_end;
+    if (!load->done) {
+        if (!in_range)
+            unload_entry(entry);
+        if (shared)
+            reload_shown_menus();
+        else if (menu_visible(load->menu))
+            load_entries(load->menu);
+        free(load->source_title);
+        free(load);
+        return;
+    }
+    if (load->icon != NULL) {
+        atlas_insert(load->icon_surface, &load->icon->region);
+        load->icon->loaded = true;
+    }
+    if (load->icon_selected != NULL) {
+        atlas_insert(load->icon_selected_surface, &load->icon_selected->region);
+        load->icon_selected->loaded = true;
+    }
+    if (load->render_title) {
+        free_atlas_region(&entry->title_region);
+        entry->title_offset = 0;
+    }
+    if (load->title != NULL) {
+        atlas_insert(load->title, &entry->title_region);
+        entry->text_rect.w = load->text_rect.w;
+        entry->text_rect.h = load->text_rect.h;
+        if (config.title_oversize_mode == OVERSIZE_SHRINK && load->title_height != geo.font_height)
+            entry->title_offset = (geo.font_height - load->title_height) / 2;
+    }
+    if (load->render_title)
+        entry->loaded = true;
+
+    // Drop an entry that was scrolled out of range while it was loading,
+    // center the title below the icon if the entry is on screen
+    if (!in_range)
+        unload_entry(entry);
+    else if (menu_visible(load->menu))
+        calculate_button_geometry(load->menu);
+
+    // Render the title again if a data source changed while it was rendered
+    if (in_range && load->render_title &&
+    sources_changed(load->menu->entry_info[load->index].title, load->sources_version)) {
+        entry->loaded = false;
+        queue_entries(load->menu, load->index, load->index + 1, PRIORITY_BACKGROUND);
+    }
+    free(load->source_title);
+    free(load);
+}
+
+// A function to select an entry of the current menu, turning the page or
+// scrolling the grid to make it visible. The highlight slides to the entry
+// if the buttons stay in place.
+static void select_entry(unsigned int position)
+{
+    unsigned int row = position / config.max_buttons;
+    unsigned int page = current_menu->page;
+    unsigned int rows = get_layout_rows();
+    if (rows == 1 || row < page)
+        page = row;
+    else if (row >= page + rows)
+        page = row - rows + 1;
+
+    // Slide to the next or previous page, its entries are already loaded
+    bool scrolled = page != current_menu->page;
+    if (rows == 1 && (page + 1 == current_menu->page || page == current_menu->page + 1))
+        scroll_page(current_menu->page, page > current_menu->page);
+    current_menu->page = page;
+    current_menu->highlight_position = position - page*config.max_buttons;
+    if (scrolled) {
+        calculate_button_geometry(current_menu);
+        load_entries(current_menu);
+    }
+    if (config.highlight)
+        move_highlight(get_current_entry(), !scrolled);
+}
+
+// A function to slide a page of the current menu off the screen while the
+// new page slides in. Only the positions of the entries of both pages change,
+// the animation takes the same time regardless of the frame rate.
+static void scroll_page(unsigned int page, bool forward)
+{
+    float distance = (float) config.max_buttons * (float) geo.x_advance;
+    page_scroll.menu = current_menu;
+    page_scroll.page = page;
+    page_scroll.distance = forward ? distance : -distance;
+    start_animation(&page_scroll.animation,
+        &page_scroll.offset,
+        page_scroll.distance,
+        0.0f,
+        PAGE_SCROLL_TIME,
+        EASING_EASE_OUT,
+        NULL,
+        NULL
+    );
+}
+
+// A function to get the horizontal offset of the entries of a menu
+// while its page slides, 0 if the menu isn't sliding
+static float get_page_offset(Menu *menu)
+{
+    if (!page_scroll.animation.active || page_scroll.menu != menu)
+        return 0.0f;
+    return page_scroll.offset;
+}
+
+// A function to get the number of rows a vertical move skips,
+// which grows the longer the direction is held
+static unsigned int get_scroll_rows()
+{
+    if (!state.input_repeat) {
+        ticks.scroll_start = ticks.main;
+        return 1;
     }
+    return MIN(1 + (ticks.main - ticks.scroll_start) / SCROLL_ACCELERATION_PERIOD, MAX_SCROLL_ROWS);
+}
+
+// A function to move the selection left when clicked by user
+static void move_left()
+{
+    if (current_menu->num_entries == 0)
+        return;
+    unsigned int position = get_current_position();
+    if (position > 0)
+        select_entry(position - 1);
+
+    // If the user has the wrap entries setting, select the last entry in the menu
+    else if (config.wrap_entries)
+        select_entry(current_menu->num_entries - 1);
 }
 
 // A function to move the selection right when clicked by the user
 static void move_right()
 {
-    // If we are not in the rightmost position, move highlight right
-    if ((int) current_menu->highlight_position < (geo.num_buttons - 1)) {
-        if (config.highlight)
-            highlight->rect.x += geo.x_advance;
-        current_menu->highlight_position++;
-        current_entry = current_entry->next;
-    }
-
-    // If we are in the rightmost postion, but there are more entries in the menu, load next page
-    else if (current_menu->highlight_position + current_menu->page*config.max_buttons <
-    (current_menu->num_entries - 1)) {
-        unsigned int buttons = current_menu->num_entries - (current_menu->page + 1)*config.max_buttons;
-        if (buttons > config.max_buttons)
-            buttons = config.max_buttons;
-        current_entry = current_entry->next;
-        current_menu->root_entry = current_entry;
-        calculate_button_geometry(current_menu->root_entry, (int) buttons);
-        if (config.highlight)
-            highlight->rect.x = current_entry->icon_rect.x - config.highlight_hpadding;
-        current_menu->page++;
-        current_menu->highlight_position = 0;
-    }
+    if (current_menu->num_entries == 0)
+        return;
+    unsigned int position = get_current_position();
+    if (position < current_menu->num_entries - 1)
+        select_entry(position + 1);
 
     // If user has the wrap entries setting, reset menu to first entry
-    else if (config.wrap_entries) {
-        current_entry = current_menu->first_entry;
-        current_menu->root_entry = current_entry;
-        current_menu->highlight_position = 0;
-        current_menu->page = 0;
-        if (config.highlight)
-            highlight->rect.x = current_entry->icon_rect.x - config.highlight_hpadding;
-        calculate_button_geometry(current_menu->root_entry, (int) MIN(current_menu->num_entries, config.max_buttons));
+    else if (config.wrap_entries)
+        select_entry(0);
+}
+
+// A function to move the selection up by one or more rows of the grid
+static void move_up()
+{
+    // Move to the previous row with entries on the home screen
+    if (home_menu != NULL) {
+        for (unsigned int i = home_menu->rows->position; i > 0; i--) {
+            if (home_menu->rows->menus[i - 1]->num_entries) {
+                select_row(i - 1);
+                break;
+            }
+        }
+        return;
+    }
+
+    unsigned int rows = get_scroll_rows();
+    unsigned int position = get_current_position();
+    unsigned int row = position / config.max_buttons;
+    if (config.rows == 1 || row == 0)
+        return;
+    select_entry(position - MIN(rows, row)*config.max_buttons);
+}
+
+// A function to move the selection down by one or more rows of the grid,
+// stopping at the last entry if the last row is not full
+static void move_down()
+{
+    // Move to the next row with entries on the home screen
+    if (home_menu != NULL) {
+        for (unsigned int i = home_menu->rows->position + 1; i < home_menu->rows->num_rows; i++) {
+            if (home_menu->rows->menus[i]->num_entries) {
+                select_row(i);
+                break;
+            }
+        }
+        return;
+    }
+
+    unsigned int rows = get_scroll_rows();
+    unsigned int position = get_current_position();
+    unsigned int row = position / config.max_buttons;
+    if (config.rows == 1 || current_menu->num_entries == 0)
+        return;
+    unsigned int last_row = (current_menu->num_entries - 1) / config.max_buttons;
+    if (row == last_row)
+        return;
+    position += MIN(rows, last_row - row)*config.max_buttons;
+    select_entry(MIN(position, current_menu->num_entries - 1));
+}
+
+// A function to move the highlight to another row of the home screen,
+// the rows scroll if it isn't visible. The row keeps its own position.
+static void select_row(unsigned int position)
+{
+    MenuRows *rows = home_menu->rows;
+    unsigned int first = rows->first;
+    rows->position = position;
+    scroll_to_row(rows);
+    current_menu = rows->menus[position];
+    current_menu->last_visit = ticks.main;
+    bool scrolled = rows->first != first;
+    if (scrolled)
+        layout_home();
+    else
+        calculate_button_geometry(current_menu);
+    if (config.highlight)
+        move_highlight(get_current_entry(), !scrolled);
+}
+
+// A function to move the highlight to an entry, sliding it there if animated
+static void move_highlight(Entry *entry, bool animate)
+{
+    float x = (float) (entry->icon_rect.x - config.highlight_hpadding);
+    float y = (float) (entry->icon_rect.y - config.highlight_vpadding);
+    if (animate) {
+        start_animation(&highlight->movement, &highlight->x, highlight->x, x, HIGHLIGHT_MOVE_TIME, EASING_EASE_OUT, NULL, NULL);
+        start_animation(&highlight->vertical_movement, &highlight->y, highlight->y, y, HIGHLIGHT_MOVE_TIME, EASING_EASE_OUT, NULL, NULL);
+    }
+    else {
+        stop_animation(&highlight->movement);
+        stop_animation(&highlight->vertical_movement);
+        highlight->x = x;
+        highlight->y = y;
     }
 }
 
 // A function to load a submenu
 static void load_submenu(const char *submenu)
 {
-    current_menu->last_selected_entry = current_entry;
     load_menu_by_name(submenu, true, true);
 }
 
@@ -758,26 +1364,148 @@ static void load_back_menu(Menu *menu)
     load_menu(menu->back, false, config.reset_on_back);
 }
 
+// A function to run the command of the selected entry, the command
+// of a search result runs from the menu the search started in
+static void select_current_entry()
+{
+    if (current_menu->num_entries == 0)
+        return;
+    EntryInfo *info = get_current_entry_info();
+    log_debug("Selected Entry:\n"
+        "Title: %s\n"
+        "Icon Path: %s\n"
+        "Command: %s", 
+        info->title, 
+        info->icon_path, 
+        info->cmd
+    );
+
+    // The results menu is only freed after the next frame
+    end_search();
+    execute_command(info->cmd);
+}
+
+// A function to start the type-ahead search, the typed text
+// filters the entries of all menus into a results menu
+static void start_search()
+{
+    if (state.searching)
+        return;
+    state.searching = true;
+    search->origin = get_shown_menu();
+    search->query[0] = '\0';
+    search->length = 0;
+    SDL_StartTextInput();
+
+    // Drop the text of the key that started the search
+    SDL_FlushEvent(SDL_TEXTINPUT);
+    update_search_results();
+}
+
+// A function to end the type-ahead search and return to the menu it started from
+static void end_search()
+{
+    if (!state.searching)
+        return;
+    state.searching = false;
+    SDL_StopTextInput();
+    if (search->texture != NULL) {
+        destroy_texture(search->texture);
+        search->texture = NULL;
+    }
+
+    // The menu may have lost its entries to a directory scan
+    if (load_menu(search->origin, false, false))
+        load_menu(default_menu, false, true);
+    clear_search();
+}
+
+// A function to show the entries that match the search query
+static void update_search_results()
+{
+    Menu *results = search_entries(search->query);
+    stop_animation(&page_scroll.animation);
+    results->back = search->origin;
+    cancel_menu(get_shown_menu());
+    home_menu = NULL;
+    current_menu = results;
+    current_menu->last_visit = ticks.main;
+    calculate_button_geometry(current_menu);
+    if (config.highlight && current_menu->num_entries)
+        move_highlight(get_current_entry(), false);
+    load_entries(current_menu);
+
+    // Render the query at the top of the screen
+    if (search->texture != NULL)
+        destroy_texture(search->texture);
+    char *prompt = NULL;
+    sprintf_alloc(&prompt, SEARCH_PROMPT_FORMAT, search->query);
+    TextInfo prompt_info = title_info;
+    prompt_info.max_width = geo.screen_width - 2*geo.screen_margin;
+    prompt_info.oversize_mode = OVERSIZE_TRUNCATE;
+    search->texture = track_texture(render_text_texture(prompt, &prompt_info, &search->rect, NULL), TEXTURE_INTERFACE);
+    search->rect.x = (geo.screen_width - search->rect.w) / 2;
+    search->rect.y = geo.screen_margin;
+    free(prompt);
+}
+
+// A function to add typed text to the search query
+static void handle_text_input(const char *text)
+{
+    size_t length = strlen(text);
+    if (search->length + length >= MAX_SEARCH_QUERY_BYTES)
+        return;
+    memcpy(search->query + search->length, text, length + 1);
+    search->length += length;
+    update_search_results();
+}
+
+// A function to remove the last character of the search query,
+// ending the search if the query is empty
+static void erase_search_character()
+{
+    if (search->length == 0) {
+        end_search();
+        return;
+    }
+
+    // Skip the continuation bytes of a multibyte UTF-8 character
+    do {
+        search->length--;
+    } while (search->length > 0 && ((Uint8) search->query[search->length] & 0xC0) == 0x80);
+    search->query[search->length] = '\0';
+    update_search_results();
+}
+
 // A function to update the screen with all visible textures
 static void draw_screen()
 {
     // Draw background
     SDL_RenderClear(renderer);
     if (!(state.application_launching && config.on_launch == ON_LAUNCH_BLANK)) {
-        if (config.background_mode == BACKGROUND_IMAGE || config.background_mode == BACKGROUND_SLIDESHOW)
+        if (config.background_mode == BACKGROUND_SLIDESHOW && config.slideshow_pan_zoom)
+            render_pan_zoom(background_texture, &slideshow->background_motion);
+        else if (config.background_mode == BACKGROUND_IMAGE || config.background_mode == BACKGROUND_SLIDESHOW)
             SDL_RenderCopy(renderer, background_texture, NULL, NULL);
 	else if (config.background_mode == BACKGROUND_VIDEO)
 		render_video_texture();
-	else if (config.background_mode == BACKGROUND_SLIDESHOW && state.slideshow_transition)
-            SDL_RenderCopy(renderer, slideshow->transition_texture, NULL, NULL);
 
-        // Draw background overlay
-        if (config.background_overlay)
+        // Fade in the next slideshow image over the current one
+        if (config.background_mode == BACKGROUND_SLIDESHOW && state.slideshow_transition) {
+            if (config.slideshow_pan_zoom)
+                render_pan_zoom(slideshow->transition_texture, &slideshow->transition_motion);
+            else
+                SDL_RenderCopy(renderer, slideshow->transition_texture, NULL, NULL);
+        }
+
+        // Draw background overlay, it is already blended into
+        // color, image and slideshow backgrounds
+        if (background_overlay != NULL)
             SDL_RenderCopy(renderer, background_overlay, NULL, NULL);
 
         // Draw scroll indicators
         if (config.scroll_indicators &&
-        (current_menu->page*config.max_buttons + (unsigned int) geo.num_buttons) <= (current_menu->num_entries - 1))
+        current_menu->page*config.max_buttons + (unsigned int) geo.num_buttons < current_menu->num_entries)
             SDL_RenderCopy(renderer, scroll->texture, NULL, &scroll->rect_right);
 
         if (config.scroll_indicators && current_menu->page > 0)
@@ -790,24 +1518,41 @@ static void draw_screen()
                 SDL_RenderCopy(renderer, clk->date_texture, NULL, &clk->date_rect);
         }
 
+        // Draw status widget
+        if (status != NULL && status->texture != NULL)
+            SDL_RenderCopy(renderer, status->texture, NULL, &status->rect);
+
+        // Draw search query
+        if (state.searching && search->texture != NULL)
+            SDL_RenderCopy(renderer, search->texture, NULL, &search->rect);
+
         // Draw highlight
-        if (config.highlight)
-            SDL_RenderCopy(renderer,
-                highlight->texture,
-                NULL,
-                &highlight->rect
-            );
+        if (config.highlight && geo.num_buttons) {
+            SDL_FRect rect = {
+                highlight->x + get_page_offset(current_menu),
+                highlight->y,
+                (float) highlight->rect.w,
+                (float) highlight->rect.h
+            };
+            SDL_RenderCopyF(renderer, highlight->texture, NULL, &rect);
+        }
 
-        // Draw buttons
-        Entry *entry = current_menu->root_entry;
-        SDL_Texture *icon;
-        for (int i = 0; i < geo.num_buttons; i++) {
-            icon = (entry->icon_selected != NULL && i == (int) current_menu->highlight_position) ? entry->icon_selected : entry->icon;
-            SDL_RenderCopy(renderer, icon, NULL, &entry->icon_rect);
-            if (config.titles_enabled)
-                SDL_RenderCopy(renderer, entry->title_texture, NULL, &entry->text_rect);
-            entry = entry-> next;
+        // Draw buttons, icons and titles from the same atlas page are drawn together
+        unsigned int num_shown = 1;
+        Menu **shown = &current_menu;
+        if (home_menu != NULL) {
+            shown = home_menu->rows->menus + home_menu->rows->first;
+            num_shown = MIN(config.rows, home_menu->rows->num_rows - home_menu->rows->first);
         }
+        for (int titles = 0; titles <= (int) config.titles_enabled; titles++) {
+            for (unsigned int i = 0; i < num_shown; i++) {
+                float offset = get_page_offset(shown[i]);
+                batch_entries(shown[i], shown[i]->page, offset, (bool) titles);
+                if (offset != 0.0f)
+                    batch_entries(shown[i], page_scroll.page, offset - page_scroll.distance, (bool) titles);
+            }
+        }
+        flush_batch();
 
         // Draw screensaver
         if (state.screensaver_active)
@@ -823,6 +1568,90 @@ static void draw_screen()
     }
 }
 
+// A function to render the titles and the status widget again if the values
+// of the data sources they show changed. Only the titles of loaded entries
+// that refer to a changed source are rendered, in worker threads.
+static void update_source_text()
+{
+    Uint32 version = get_sources_version();
+    if (version == sources_version)
+        return;
+    Menu *menu = config.first_menu;
+    for (size_t i = 0; i < config.num_menus; i++, menu = menu->next)
+        refresh_titles(menu, sources_version);
+    if (state.searching)
+        refresh_titles(current_menu, sources_version);
+    if (status != NULL) {
+        render_status();
+        state.redraw = true;
+    }
+    sources_version = version;
+}
+
+// A function to render the titles of the loaded entries of a menu
+// again if they refer to a data source that changed after a version
+static void refresh_titles(Menu *menu, Uint32 since)
+{
+    JobPriority priority = menu_visible(menu) ? PRIORITY_INTERACTIVE : PRIORITY_BACKGROUND;
+    for (unsigned int i = menu->load_start; i < menu->load_end; i++) {
+        Entry *entry = menu->entries + i;
+        if (!entry->loaded || entry->job != NULL || !sources_changed(menu->entry_info[i].title, since))
+            continue;
+        entry->loaded = false;
+        queue_entries(menu, i, i + 1, priority);
+    }
+}
+
+// A function to render the status widget at the bottom of the
+// screen with the latest values of the data sources
+static void render_status()
+{
+    if (status->texture != NULL) {
+        destroy_texture(status->texture);
+        status->texture = NULL;
+    }
+    char *text = expand_sources(config.status_text);
+    if (text[0] != '\0') {
+        TextInfo status_info = title_info;
+        status_info.max_width = geo.screen_width - 2*geo.screen_margin;
+        status_info.oversize_mode = OVERSIZE_TRUNCATE;
+        status->texture = track_texture(render_text_texture(text, &status_info, &status->rect, NULL), TEXTURE_INTERFACE);
+        if (config.status_alignment == ALIGNMENT_LEFT)
+            status->rect.x = geo.screen_margin;
+        else
+            status->rect.x = geo.screen_width - geo.screen_margin - status->rect.w;
+        status->rect.y = geo.screen_height - geo.screen_margin - status->rect.h;
+    }
+    free(text);
+}
+
+// A function to queue the icons or titles of the entries of a page of a menu for drawing
+static void batch_entries(Menu *menu, unsigned int page_number, float x_offset, bool titles)
+{
+    unsigned int first = page_number*config.max_buttons;
+    if (first >= menu->num_entries)
+        return;
+    unsigned int count = MIN(get_layout_rows()*config.max_buttons, menu->num_entries - first);
+    Entry *page = menu->entries + first;
+    AtlasRegion *icon;
+    for (unsigned int i = 0; i < count; i++) {
+        Entry *entry = page + i;
+        if (titles) {
+            batch_quad(&entry->title_region, &entry->text_rect, x_offset);
+            continue;
+        }
+        if (entry->icon == NULL || !entry->icon->loaded)
+            icon = &placeholder;
+        else if (entry->icon_selected != NULL && entry->icon_selected->loaded &&
+        entry->icon_selected->region.texture != NULL &&
+        menu == current_menu && page_number == menu->page && i == menu->highlight_position)
+            icon = &entry->icon_selected->region;
+        else
+            icon = &entry->icon->region;
+        batch_quad(icon, &entry->icon_rect, x_offset);
+    }
+}
+
 // A function to execute the user's command
 static void execute_command(const char *command)
 {
@@ -835,8 +1664,10 @@ static void execute_command(const char *command)
         char *special_command = strtok(cmd, delimiter);
         if (!strcmp(special_command, SCMD_SUBMENU)) {
             char *submenu = strtok(NULL, "");
-            if (submenu != NULL)
+            if (submenu != NULL) {
+                end_search();
                 load_submenu(submenu);
+            }
         }
         else if (!strcmp(special_command, SCMD_FORK)) {
             char *fork_command = strtok(NULL, "");
@@ -847,12 +1678,36 @@ static void execute_command(const char *command)
             move_left();
         else if (!strcmp(special_command, SCMD_RIGHT))
             move_right();
+        else if (!strcmp(special_command, SCMD_UP))
+            move_up();
+        else if (!strcmp(special_command, SCMD_DOWN))
+            move_down();
+        else if (!strcmp(special_command, SCMD_NEXT_BACKGROUND)) {
+            if (config.background_mode == BACKGROUND_SLIDESHOW)
+                next_slideshow_background();
+        }
+        else if (!strcmp(special_command, SCMD_PREVIOUS_BACKGROUND)) {
+            if (config.background_mode == BACKGROUND_SLIDESHOW)
+                previous_slideshow_background();
+        }
         else if (!strcmp(special_command, SCMD_SELECT))
-            execute_command(current_entry->cmd);
-        else if (!strcmp(special_command, SCMD_HOME))
+            select_current_entry();
+        else if (!strcmp(special_command, SCMD_HOME)) {
+            end_search();
             load_menu(default_menu, false, true);
-        else if (!strcmp(special_command, SCMD_BACK))
-            load_back_menu(current_menu);
+        }
+        else if (!strcmp(special_command, SCMD_BACK)) {
+            if (state.searching)
+                end_search();
+            else
+                load_back_menu(get_shown_menu());
+        }
+        else if (!strcmp(special_command, SCMD_SEARCH)) {
+            if (state.searching)
+                end_search();
+            else
+                start_search();
+        }
         else if (!strcmp(special_command, SCMD_QUIT))
             quit(EXIT_SUCCESS);
         else if (!strcmp(special_command, SCMD_SHUTDOWN))
@@ -1006,67 +1861,276 @@ static void poll_gamepad()
         if (i->repeat == 1) {
             log_debug("Gamepad %s detected", i->label);
             ticks.last_input = ticks.main;
+            state.input_repeat = false;
+            state.redraw = true;
             execute_command(i->cmd);
         }
         else if (i->repeat == delay_period) {
             ticks.last_input = ticks.main;
+            state.input_repeat = true;
+            state.redraw = true;
             execute_command(i->cmd);
             i->repeat -= repeat_period;
         }
     }
 }
 
+// A function to determine if a gamepad control is held, its
+// repeats are counted every frame
+static bool gamepad_pressed()
+{
+    for (GamepadControl *i = gamepad_controls; i != NULL; i = i->next) {
+        if (i->repeat)
+            return true;
+    }
+    return false;
+}
+
+// A function to determine if the screen changes every frame without an event
+static bool screen_animating()
+{
+    return animations_running() ||
+        config.background_mode == BACKGROUND_VIDEO ||
+        (config.background_mode == BACKGROUND_SLIDESHOW && config.slideshow_pan_zoom) ||
+        (gamepads != NULL && gamepad_pressed());
+}
+
+// A function to lower a timeout to a number of milliseconds, -1 is no timeout
+static void limit_timeout(int *timeout, int milliseconds)
+{
+    if (milliseconds >= 0 && (*timeout < 0 || milliseconds < *timeout))
+        *timeout = milliseconds;
+}
+
+// A function to get the number of milliseconds until a tick count, 0 if it has passed
+static int get_time_until(Uint32 deadline)
+{
+    Sint32 remaining = (Sint32) (deadline - SDL_GetTicks());
+    return remaining > 0 ? (int) remaining : 0;
+}
+
+// A function to get the number of milliseconds the main loop can wait for
+// events before the screen is due to change, 0 if it changes every frame
+// and -1 if only an event can change it
+static int get_idle_timeout()
+{
+    if (state.redraw || screen_animating())
+        return 0;
+    int timeout = -1;
+    if (state.application_launching) {
+        limit_timeout(&timeout, get_time_until(ticks.application_launched + config.application_timeout + 1));
+        return timeout;
+    }
+    if (config.clock_enabled && !state.clock_rendering) {
+        Uint32 period = get_clock_timeout();
+        if (period <= CLOCK_UPDATE_PERIOD)
+            period = CLOCK_UPDATE_PERIOD + 1;
+        limit_timeout(&timeout, get_time_until(ticks.clock_update + period));
+    }
+    // A slideshow image that is still being prefetched wakes the loop once it's loaded
+    if (config.background_mode == BACKGROUND_SLIDESHOW && !state.slideshow_transition &&
+    !state.slideshow_paused && !state.slideshow_background_rendering)
+        limit_timeout(&timeout, get_time_until(ticks.slideshow_load + config.slideshow_image_duration + 1));
+    if (config.screensaver_enabled && !state.screensaver_active)
+        limit_timeout(&timeout, get_time_until(ticks.last_input + config.screensaver_idle_time + 1));
+    limit_timeout(&timeout, get_sources_timeout());
+    return timeout;
+}
+
+// A function to sleep until the next event or until the timeout expires, -1
+// waits without a timeout. SDL checks for events every millisecond while it
+// waits if a gamepad is open, so the launcher sleeps in longer slices instead.
+static void wait_for_event(int timeout)
+{
+    if (gamepads == NULL) {
+        SDL_WaitEventTimeout(NULL, timeout);
+        return;
+    }
+    Uint32 start = SDL_GetTicks();
+    int remaining = timeout;
+    while (timeout < 0 || remaining > 0) {
+        SDL_Delay((Uint32) (timeout < 0 ? GAMEPAD_WAIT_INTERVAL : MIN(remaining, GAMEPAD_WAIT_INTERVAL)));
+        SDL_PumpEvents();
+        if (SDL_HasEvents(SDL_FIRSTEVENT, SDL_LASTEVENT))
+            return;
+        remaining = timeout - (int) (SDL_GetTicks() - start);
+    }
+}
+
 // A function to update the slideshow
 static void update_slideshow()
 {
-    // If image duration time has elapsed, load the next image and start the transition
+    // Prefetch the next image as soon as possible, rendering it in a
+    // worker thread so we don't block the main thread
+    if (slideshow->next_texture == NULL && !state.slideshow_background_rendering) {
+        submit_job(PRIORITY_BACKGROUND,
+            load_next_slideshow_background_async,
+            complete_slideshow_background,
+            (void*) slideshow
+        );
+        state.slideshow_background_rendering = true;
+    }
+
+    // If image duration time has elapsed, start the transition to the next image
     if (!state.slideshow_transition && (ticks.main - ticks.slideshow_load > config.slideshow_image_duration) &&
-    !state.slideshow_paused) {
-        
-        // Render the new background image in a separate thread so we don't block the main thread
-        if (!state.slideshow_background_rendering && !state.slideshow_background_ready) {
-            Slideshowhread = SDL_CreateThread(load_next_slideshow_background_async, "Slideshow Thread", (void*) slideshow);
-            state.slideshow_background_rendering = true;
-        }
+    !state.slideshow_paused)
+        next_slideshow_background();
 
-        // Convert background to texture after the rendering thread has completed
-        else if (state.slideshow_background_ready) {
-            SDL_WaitThread(Slideshowhread, NULL);
-            Slideshowhread = NULL;
-            if (config.slideshow_transition_time > 0) {
-                slideshow->transition_texture = load_texture(slideshow->transition_surface);
-                SDL_SetTextureAlphaMod(slideshow->transition_texture, 0);
-                state.slideshow_transition = true;
-            }
-            else {
-                SDL_DestroyTexture(background_texture);
-                background_texture = load_texture(slideshow->transition_surface);
-                ticks.slideshow_load = ticks.main;
-            }
-        slideshow->transition_surface = NULL;
-        state.slideshow_background_ready = false;
-        }
+    // Apply the transparency of the running transition
+    else if (state.slideshow_transition)
+        SDL_SetTextureAlphaMod(slideshow->transition_texture, (Uint8) slideshow->transition_alpha);
+}
+
+// A function to convert the prefetched slideshow image to a texture
+// after the worker thread has completed
+static void complete_slideshow_background(void *data, bool cancelled)
+{
+    (void) cancelled;
+    Slideshow *loaded = (Slideshow*) data;
+    SDL_Surface *surface = check_slideshow_surface(loaded, loaded->transition_surface, loaded->load_attempts);
+    state.slideshow_background_rendering = false;
+
+    // The slideshow may have been stopped if no image could be loaded
+    if (config.background_mode != BACKGROUND_SLIDESHOW)
+        return;
+    loaded->transition_surface = NULL;
+    loaded->next_texture = track_texture(load_texture(surface), TEXTURE_SLIDESHOW);
+    loaded->texture_bytes += get_texture_bytes(loaded->next_texture);
+}
+
+// A function to show a slideshow texture, fading it in over the current one
+static void show_slideshow_background(SDL_Texture *texture)
+{
+    if (config.slideshow_pan_zoom)
+        init_pan_zoom(config.slideshow_transition_time > 0 ? &slideshow->transition_motion : &slideshow->background_motion);
+    if (config.slideshow_transition_time > 0) {
+        // Images are uploaded in their native format, the crossfade
+        // only needs texture alpha modulation, not per pixel alpha
+        slideshow->transition_texture = texture;
+        start_animation(&slideshow->transition,
+            &slideshow->transition_alpha,
+            0.0f,
+            255.0f,
+            config.slideshow_transition_time,
+            EASING_LINEAR,
+            complete_slideshow_transition,
+            NULL
+        );
+        SDL_SetTextureBlendMode(slideshow->transition_texture, SDL_BLENDMODE_BLEND);
+        SDL_SetTextureAlphaMod(slideshow->transition_texture, 0);
+        state.slideshow_transition = true;
     }
-    else if (state.slideshow_transition) {
-        
-        // Increase the transparency
-        slideshow->transition_alpha += slideshow->transition_change_rate;
-        
-        // If transition is done, destroy old background and replace it with the new one
-        if (slideshow->transition_alpha >= 255.0f) {
-            SDL_SetTextureAlphaMod(slideshow->transition_texture, 0xFF);
-            slideshow->transition_alpha = 0.0f;
-            SDL_DestroyTexture(background_texture);
-            background_texture = slideshow->transition_texture;
-            slideshow->transition_texture = NULL;
-            state.slideshow_transition = false;
-            ticks.slideshow_load = ticks.main;
-        }
-        else
-            SDL_SetTextureAlphaMod(slideshow->transition_texture, (Uint8) slideshow->transition_alpha);
+    else {
+        background_texture = texture;
+        ticks.slideshow_load = ticks.main;
+        state.redraw = true;
     }
 }
 
+// A function to complete a running slideshow transition immediately
+static void finish_slideshow_transition()
+{
+    if (!state.slideshow_transition)
+        return;
+    stop_animation(&slideshow->transition);
+    SDL_SetTextureAlphaMod(slideshow->transition_texture, 0xFF);
+    slideshow->transition_alpha = 0.0f;
+    background_texture = slideshow->transition_texture;
+    slideshow->background_motion = slideshow->transition_motion;
+    slideshow->transition_texture = NULL;
+    state.slideshow_transition = false;
+    ticks.slideshow_load = ticks.main;
+}
+
+// A function to replace the old background with the new one once the transition is done
+static void complete_slideshow_transition(void *data)
+{
+    (void) data;
+    finish_slideshow_transition();
+}
+
+// A function to add a texture to the slideshow history, the oldest textures
+// are destroyed when the history exceeds its length or memory limit
+static void push_slideshow_history(SDL_Texture *texture)
+{
+    if (slideshow->history_length == MAX_SLIDESHOW_HISTORY) {
+        slideshow->texture_bytes -= get_texture_bytes(slideshow->history[0]);
+        destroy_texture(slideshow->history[0]);
+        memmove(slideshow->history, slideshow->history + 1, (MAX_SLIDESHOW_HISTORY - 1) * sizeof(SDL_Texture*));
+        slideshow->history_length--;
+        slideshow->history_position--;
+    }
+    slideshow->history[slideshow->history_length++] = texture;
+
+    // Always keep the current and the new texture
+    Sint64 max_bytes = (Sint64) config.slideshow_history_size * BYTES_PER_MEGABYTE;
+    while (slideshow->texture_bytes > max_bytes && slideshow->history_length > 2) {
+        slideshow->texture_bytes -= get_texture_bytes(slideshow->history[0]);
+        destroy_texture(slideshow->history[0]);
+        memmove(slideshow->history, slideshow->history + 1, (size_t) (slideshow->history_length - 1) * sizeof(SDL_Texture*));
+        slideshow->history_length--;
+        slideshow->history_position--;
+    }
+}
+
+// A function to show the next slideshow image, stepping forward through
+// the history before showing the prefetched image
+static void next_slideshow_background()
+{
+    finish_slideshow_transition();
+    if (slideshow->history_position < slideshow->history_length - 1)
+        show_slideshow_background(slideshow->history[++slideshow->history_position]);
+    else if (slideshow->next_texture != NULL) {
+        push_slideshow_history(slideshow->next_texture);
+        slideshow->next_texture = NULL;
+        slideshow->history_position = slideshow->history_length - 1;
+        show_slideshow_background(slideshow->history[slideshow->history_position]);
+    }
+
+    // Show the next image as soon as it has been prefetched
+    else
+        ticks.slideshow_load = ticks.main - config.slideshow_image_duration - 1;
+}
+
+// A function to show the previous slideshow image from the history
+static void previous_slideshow_background()
+{
+    finish_slideshow_transition();
+    if (slideshow->history_position > 0)
+        show_slideshow_background(slideshow->history[--slideshow->history_position]);
+}
+
+// A function to pick a random pan and zoom motion for a slideshow image,
+// lasting until the next image has faded in completely
+static void init_pan_zoom(PanZoom *motion)
+{
+    Uint64 *state = &slideshow->motion_random_state;
+    bool zoom_in = random_next(state) & 1;
+    motion->start_ticks = ticks.main;
+    motion->duration = config.slideshow_image_duration + 2 * config.slideshow_transition_time;
+    motion->start_zoom = zoom_in ? 1.0f : PAN_ZOOM_SCALE;
+    motion->end_zoom = zoom_in ? PAN_ZOOM_SCALE : 1.0f;
+    motion->start_pan.x = (float) (random_next(state) >> 40) / (float) (1 << 24);
+    motion->start_pan.y = (float) (random_next(state) >> 40) / (float) (1 << 24);
+    motion->end_pan.x = (float) (random_next(state) >> 40) / (float) (1 << 24);
+    motion->end_pan.y = (float) (random_next(state) >> 40) / (float) (1 << 24);
+}
+
+// A function to draw a slideshow image at its current pan and zoom, the texture
+// is only moved and scaled by the GPU, never uploaded again
+static void render_pan_zoom(SDL_Texture *texture, PanZoom *motion)
+{
+    Uint32 elapsed = ticks.main - motion->start_ticks;
+    float t = elapsed < motion->duration ? (float) elapsed / (float) motion->duration : 1.0f;
+    float zoom = motion->start_zoom + (motion->end_zoom - motion->start_zoom) * t;
+    SDL_FRect rect;
+    rect.w = (float) geo.screen_width * zoom;
+    rect.h = (float) geo.screen_height * zoom;
+    rect.x = ((float) geo.screen_width - rect.w) * (motion->start_pan.x + (motion->end_pan.x - motion->start_pan.x) * t);
+    rect.y = ((float) geo.screen_height - rect.h) * (motion->start_pan.y + (motion->end_pan.y - motion->start_pan.y) * t);
+    SDL_RenderCopyF(renderer, texture, NULL, &rect);
+}
+
 // A function to update the screensaver
 static void update_screensaver()
 {
@@ -1074,24 +2138,27 @@ static void update_screensaver()
     if (!state.screensaver_active && ticks.main - ticks.last_input > config.screensaver_idle_time) {
         state.screensaver_active = true;
         state.screensaver_transition = true;
+        start_animation(&screensaver->transition,
+            &screensaver->alpha,
+            0.0f,
+            screensaver->alpha_end_value,
+            SCREENSAVER_TRANSITION_TIME,
+            EASING_LINEAR,
+            complete_screensaver_transition,
+            NULL
+        );
         if (config.background_mode == BACKGROUND_SLIDESHOW && config.screensaver_pause_slideshow)
             state.slideshow_paused = true;
     }
     else {
 
         // Transition the screen to dark
-        if (state.screensaver_transition) {
-            screensaver->alpha += screensaver->transition_change_rate;
-            if (screensaver->alpha >= screensaver->alpha_end_value) {
-                SDL_SetTextureAlphaMod(screensaver->texture, (Uint8) screensaver->alpha_end_value);
-                state.screensaver_transition = false;
-            }
-            else
-                SDL_SetTextureAlphaMod(screensaver->texture, (Uint8) screensaver->alpha);
-        }
+        if (state.screensaver_transition)
+            SDL_SetTextureAlphaMod(screensaver->texture, (Uint8) screensaver->alpha);
 
         // User has pressed input, deactivate the screensaver
         if (state.screensaver_active && ticks.last_input == ticks.main) {
+            stop_animation(&screensaver->transition);
             SDL_SetTextureAlphaMod(screensaver->texture, 0);
             screensaver->alpha = 0.0f;
             state.screensaver_active = false;
@@ -1107,6 +2174,14 @@ static void update_screensaver()
     }
 }
 
+// A function to set the final screensaver darkness once the transition is done
+static void complete_screensaver_transition(void *data)
+{
+    (void) data;
+    SDL_SetTextureAlphaMod(screensaver->texture, (Uint8) screensaver->alpha_end_value);
+    state.screensaver_transition = false;
+}
+
 // A function to update the clock display
 static void update_clock(bool block)
 {
@@ -1117,34 +2192,36 @@ static void update_clock(bool block)
             get_time(clk);
             if (clk->render_time) {
                 state.clock_rendering = true;
-                if (block)
+                if (block) {
                     render_clock(clk);
+                    complete_clock(clk, false);
+                }
                 else
-                    clock_thread = SDL_CreateThread(render_clock_async, "Clock Thread", (void*) clk); 
+                    submit_job(PRIORITY_INTERACTIVE, render_clock_async, complete_clock, (void*) clk);
             }
             else
                 ticks.clock_update = ticks.main;
         }
+    }
+}
 
-        // Render texture
-        if (state.clock_ready) {
-            SDL_WaitThread(clock_thread, NULL);
-            clock_thread = NULL;
-            SDL_DestroyTexture(clk->time_texture);
-            clk->time_texture = load_texture(clk->time_surface);
-            clk->time_surface = NULL;
-            if (clk->render_date) {
-                SDL_DestroyTexture(clk->date_texture);
-                clk->date_texture = load_texture(clk->date_surface);
-                clk->date_surface = NULL;
-            }
-            ticks.clock_update = ticks.main;
-            clk->render_time = false;
-            clk->render_date = false;
-            state.clock_rendering = false;
-            state.clock_ready = false;
-        }
+// A function to convert the clock to textures after it was rendered
+static void complete_clock(void *data, bool cancelled)
+{
+    (void) cancelled;
+    Clock *rendered = (Clock*) data;
+    destroy_texture(rendered->time_texture);
+    rendered->time_texture = track_texture(load_texture(rendered->time_surface), TEXTURE_CLOCK);
+    rendered->time_surface = NULL;
+    if (rendered->render_date) {
+        destroy_texture(rendered->date_texture);
+        rendered->date_texture = track_texture(load_texture(rendered->date_surface), TEXTURE_CLOCK);
+        rendered->date_surface = NULL;
     }
+    ticks.clock_update = ticks.main;
+    rendered->render_time = false;
+    rendered->render_date = false;
+    state.clock_rendering = false;
 }
 
 static inline void pre_launch()
@@ -1177,8 +2254,8 @@ static inline void post_launch()
 
 #ifdef _WIN32
     SDL_EventState(SDL_SYSWMEVENT, SDL_DISABLE);
-    if (config.background_mode == BACKGROUND_TRANSPARENT)
-        hide_cursor(current_entry);
+    if (config.background_mode == BACKGROUND_TRANSPARENT && current_menu->num_entries)
+        hide_cursor(get_current_entry());
 #endif
 }
 
@@ -1235,6 +2312,8 @@ int main(int argc, char *argv[])
 
     // Initialize SDL, verify all settings are in their allowable range
     init_sdl();
+    init_textures();
+    init_workers();
     init_sdl_image();
     init_sdl_ttf();
     validate_settings(&geo);
@@ -1243,6 +2322,20 @@ int main(int argc, char *argv[])
     init_svg();
     create_window();
 
+    // Initialize image cache
+    if (config.background_mode == BACKGROUND_IMAGE || config.background_mode == BACKGROUND_SLIDESHOW)
+        init_image_cache();
+
+    // Fill directory menus from their index, scan the directories in the background
+    init_directory_menus();
+
+    // Index the entries of all menus for the type-ahead search, text
+    // input is only enabled while searching
+    init_search();
+    search = malloc(sizeof(Search));
+    search->texture = NULL;
+    SDL_StopTextInput();
+
     // Initialize slideshow
     if (config.background_mode == BACKGROUND_SLIDESHOW)
         init_slideshow();
@@ -1269,8 +2362,17 @@ int main(int argc, char *argv[])
     if (config.background_mode == BACKGROUND_IMAGE) {
         if (config.background_image == NULL)
             log_error("Background 'Image' setting not specified in config file");
-        else
-            background_texture = load_texture_from_file(config.background_image);
+        else {
+            ImageInfo info;
+            read_image_info(config.background_image, &info);
+            background_texture = track_texture(load_texture(load_background_surface(config.background_image,
+                                         geo.screen_width,
+                                         geo.screen_height,
+                                         info.orientation
+                                     )),
+                                     TEXTURE_BACKGROUND
+                                 );
+        }
 
         // Switch to color mode if loading background image failed
         if (background_texture == NULL) {
@@ -1282,8 +2384,16 @@ int main(int argc, char *argv[])
 
     // Render first slideshow image
     else if (config.background_mode == BACKGROUND_SLIDESHOW) {
-        SDL_Surface *surface = load_next_slideshow_background(slideshow, false);
-        background_texture = load_texture(surface);
+        SDL_Surface *surface = load_next_slideshow_background(slideshow);
+        if (config.background_mode == BACKGROUND_SLIDESHOW)
+            background_texture = track_texture(load_texture(surface), TEXTURE_SLIDESHOW);
+        if (config.background_mode == BACKGROUND_SLIDESHOW && background_texture != NULL) {
+            slideshow->texture_bytes += get_texture_bytes(background_texture);
+            push_slideshow_history(background_texture);
+            if (config.slideshow_pan_zoom)
+                init_pan_zoom(&slideshow->background_motion);
+            slideshow->history_position = 0;
+        }
     }
 
     // Initialize screensaver
@@ -1297,16 +2407,32 @@ int main(int argc, char *argv[])
         ticks.clock_update = ticks.main;
     }
     
+    // Render status widget, it is rendered again when a data source changes
+    if (config.status_enabled && config.status_text != NULL) {
+        status = malloc(sizeof(Status));
+        status->texture = NULL;
+        render_status();
+    }
+
     // Render highlight
     if (config.highlight) {
         int button_height = config.icon_size + config.title_padding + geo.font_height;
         highlight = malloc(sizeof(Highlight));
-        highlight->texture = render_highlight(config.icon_size + 2*config.highlight_hpadding,
-                                button_height + 2*config.highlight_vpadding,
-                                &highlight->rect
-                            );
+        highlight->movement.active = false;
+        highlight->vertical_movement.active = false;
+        highlight->texture = track_texture(render_highlight(config.icon_size + 2*config.highlight_hpadding,
+                                               button_height + 2*config.highlight_vpadding,
+                                               &highlight->rect
+                                           ),
+                                 TEXTURE_INTERFACE
+                             );
     }
 
+    // Render the placeholder for icons that are still loading
+    init_atlas();
+    atlas_insert(render_placeholder(config.icon_size), &placeholder);
+    init_icon_cache();
+
     // Render scroll indicators
     if (config.scroll_indicators) {
         scroll = malloc(sizeof(Scroll));
@@ -1315,8 +2441,9 @@ int main(int argc, char *argv[])
         render_scroll_indicators(scroll, scroll_indicator_height, &geo);
     }
 
-    // Render background overlay
-    if (config.background_overlay) {
+    // Render background overlay for the modes it can't be blended into
+    if (config.background_overlay &&
+    (config.background_mode == BACKGROUND_TRANSPARENT || config.background_mode == BACKGROUND_VIDEO)) {
         SDL_Surface *overlay_surface = NULL;
         overlay_surface = SDL_CreateRGBSurfaceWithFormat(0, 
                               geo.screen_width, 
@@ -1331,7 +2458,7 @@ int main(int argc, char *argv[])
                                    config.background_overlay_color.a
                                );
         SDL_FillRect(overlay_surface, NULL, overlay_color);
-        background_overlay = load_texture(overlay_surface);
+        background_overlay = track_texture(load_texture(overlay_surface), TEXTURE_BACKGROUND);
     }
 
     // Register exit hotkey with Windows
@@ -1359,6 +2486,7 @@ int main(int argc, char *argv[])
         execute_command(config.startup_cmd);
     
     // Main program loop
+    bool animated = false;
     log_debug("Begin program loop");
     while (1) {
         ticks.main = SDL_GetTicks();
@@ -1369,14 +2497,25 @@ int main(int argc, char *argv[])
                     break;
 
                 case SDL_KEYDOWN:
+                    state.redraw = true;
                     ticks.last_input = ticks.main;
+                    state.input_repeat = event.key.repeat != 0;
                     handle_keypress(&event.key.keysym);
                     break;
                 
+                case SDL_TEXTINPUT:
+                    if (state.searching) {
+                        state.redraw = true;
+                        ticks.last_input = ticks.main;
+                        handle_text_input(event.text.text);
+                    }
+                    break;
+
                 case SDL_MOUSEBUTTONDOWN:
                     if (config.mouse_select && event.button.button == SDL_BUTTON_LEFT) {
+                        state.redraw = true;
                         ticks.last_input = ticks.main;
-                        execute_command(current_entry->cmd);
+                        select_current_entry();
                     }
                     break;
 
@@ -1397,6 +2536,7 @@ int main(int argc, char *argv[])
                     break;
 
                 case SDL_WINDOWEVENT:
+                    state.redraw = true;
                     if (event.window.event == SDL_WINDOWEVENT_FOCUS_LOST) {
                         log_debug("Lost keyboard focus");
                         state.has_focus = false;
@@ -1426,15 +2566,21 @@ int main(int argc, char *argv[])
             }
         }
 
+        // Convert the results of background jobs, completed jobs wake the loop with an event
+        if (complete_jobs())
+            state.redraw = true;
+
         // Update application state
         if (state.application_running && state.has_focus && !process_running()) {
             state.application_running = false;
+            state.redraw = true;
             post_launch();
             log_debug("Application finished");
         }
 
         // Post-event loop updates
         if (!(state.application_running || state.application_launching)) {
+            update_animations(ticks.main);
             if (gamepads != NULL)
                 poll_gamepad();
             if (config.background_mode == BACKGROUND_SLIDESHOW)
@@ -1443,17 +2589,48 @@ int main(int argc, char *argv[])
                 update_screensaver();
             if (config.clock_enabled)
                 update_clock(false);
+
+            // Add files found by directory scans, refresh the layout if a shown menu grew
+            Uint32 version = get_directory_menus_version();
+            update_directory_menus(menu_visible);
+            if (get_directory_menus_version() != version) {
+                state.redraw = true;
+                refresh_menu();
+            }
+
+            // Refresh data sources in the background, render the text that shows them
+            update_sources();
+            update_source_text();
+
+            // Free the search results that are no longer shown
+            update_search();
+            update_prefetch();
+            evict_menus();
         }
         if (state.application_launching &&
         ticks.main - ticks.application_launched > config.application_timeout) {
             state.application_launching = false;
+            state.redraw = true;
             if (config.on_launch == ON_LAUNCH_BLANK)
                 set_draw_color();
         }
         if (state.application_running)
             SDL_Delay(APPLICATION_WAIT_PERIOD);
-        else
-            draw_screen();
+        else {
+            // Only draw the screen if it changed, one more frame is drawn
+            // after an animation stopped so it shows the final values
+            bool animating = screen_animating();
+            if (state.redraw || animating || animated) {
+                state.redraw = false;
+                draw_screen();
+            }
+            animated = animating;
+
+            // Sleep until the next event or until the screen is due to change
+            int timeout = get_idle_timeout();
+            if (timeout)
+                wait_for_event(timeout);
+        }
     }
     quit(EXIT_SUCCESS);
 }
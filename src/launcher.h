@@ -22,6 +22,7 @@
 #define GAMEPAD_DEADZONE 10000
 #define GAMEPAD_REPEAT_DELAY 500
 #define GAMEPAD_REPEAT_INTERVAL 25
+#define GAMEPAD_WAIT_INTERVAL 16 // Milliseconds slept between event checks while a gamepad is open
 #define CLOCK_UPDATE_PERIOD 1000
 #define SCROLL_INDICATOR_HEIGHT 0.11F
 #define MAX_SCROLL_INDICATOR_OUTLINE 0.01F
@@ -32,10 +33,30 @@
 #define MIN_SLIDESHOW_IMAGE_DURATION 5000
 #define MAX_SLIDESHOW_IMAGE_DURATION 3600000
 #define MAX_SLIDESHOW_TRANSITION_TIME 3000
+#define MAX_SLIDESHOW_HISTORY_SIZE 4096
+#define MAX_SLIDESHOW_HISTORY 16
 #define MIN_SCREENSAVER_IDLE_TIME 3
 #define MAX_SCREENSAVER_IDLE_TIME 900
 #define SCREENSAVER_TRANSITION_TIME 1500
+#define HIGHLIGHT_MOVE_TIME 100
+#define PAGE_SCROLL_TIME 250
+#define MIN_MENU_ENTRIES 8
+#define PREFETCH_ROWS 1 // Rows on either side of the visible ones to load in advance
+#define SCROLL_ACCELERATION_PERIOD 750
+#define MAX_SCROLL_ROWS 16
+#define PAN_ZOOM_SCALE 1.1F
 #define APPLICATION_WAIT_PERIOD 100
+#define MAX_IMAGE_CACHE_SIZE 65536
+#define MAX_PREFETCH_SIZE 1024
+#define MAX_TEXTURE_BUDGET 65536
+#define BYTES_PER_MEGABYTE 1048576
+#define PERMUTATION_ROUNDS 4
+#define MAX_PROBE_THREADS 4
+#define MIN_SLIDESHOW_IMAGE_DIMENSION 128
+#define MAX_SLIDESHOW_IMAGE_DIMENSION 16384
+#define MAX_SEARCH_QUERY_BYTES 256
+#define SEARCH_PROMPT_FORMAT "Search: %s"
+
 #define MIN_APPLICATION_TIMEOUT 3
 #define MAX_APPLICATION_TIMEOUT 30
 
@@ -46,12 +67,17 @@
 #define SCMD_EXIT ":exit"
 #define SCMD_LEFT ":left"
 #define SCMD_RIGHT ":right"
+#define SCMD_UP ":up"
+#define SCMD_DOWN ":down"
+#define SCMD_NEXT_BACKGROUND ":nextbackground"
+#define SCMD_PREVIOUS_BACKGROUND ":previousbackground"
 #define SCMD_HOME ":home"
 #define SCMD_BACK ":back"
 #define SCMD_QUIT ":quit"
 #define SCMD_SHUTDOWN ":shutdown"
 #define SCMD_RESTART ":restart"
 #define SCMD_SLEEP ":sleep"
+#define SCMD_SEARCH ":search"
 
 typedef enum {
     MODE_SETTING_BACKGROUND,
@@ -105,11 +131,6 @@ typedef enum {
     TYPE_AXIS_NEG,
 } ControlType;
 
-typedef enum {
-    DIRECTION_LEFT,
-    DIRECTION_RIGHT,
-} Direction;
-
 // Program states
 typedef struct {
     bool application_launching;
@@ -117,12 +138,13 @@ typedef struct {
     bool has_focus;
     bool slideshow_transition;
     bool slideshow_background_rendering;
-    bool slideshow_background_ready;
     bool slideshow_paused;
     bool screensaver_active;
     bool screensaver_transition;
     bool clock_rendering;
-    bool clock_ready;
+    bool input_repeat; // The current input comes from a held key or button
+    bool searching;
+    bool redraw; // The screen changed since it was last drawn
 } State;
 
 // Timing information
@@ -133,38 +155,140 @@ typedef struct {
     Uint32 last_input;
     Uint32 clock_update;
     Uint32 application_exited;
+    Uint32 scroll_start; // Start of the current held vertical scroll
 } Ticks;
 
-// Linked list for menu entries
+// Area of a texture atlas page, or a whole texture
+typedef struct {
+    SDL_Texture *texture;
+    SDL_Rect rect;
+    SDL_Rect slot; // Space reserved in the atlas page, including padding
+} AtlasRegion;
+
+// Icon texture shared by all entries showing the same file at the same size
+typedef struct icon {
+    char          *path; // Canonical path
+    int           size;
+    Uint32        hash;
+    int           references;
+    AtlasRegion   region;
+    bool          loaded;
+    struct entry  *loader; // Entry whose job loads the icon
+    struct icon   *next; // Next icon in the same hash bucket
+} Icon;
+
+// Layout and textures of a menu entry, used every frame
 typedef struct entry {
-    char           *title;
-    char           *icon_path;
-    char           *icon_selected_path;
-    char           *cmd;
-    SDL_Texture    *icon;
-    SDL_Texture    *icon_selected;
+    Icon           *icon;
+    Icon           *icon_selected;
     SDL_Rect       icon_rect;
-    SDL_Texture    *title_texture;
+    AtlasRegion    title_region;
     SDL_Rect       text_rect;
     int            title_offset;
-    struct entry   *next;
-    struct entry   *previous;
+    bool           loaded; // Title rendered
+    struct job     *job; // Pending load of the title and icons
 } Entry;
 
-// Linked list for menus
+// Strings of a menu entry, only used when loading or launching it
+typedef struct {
+    char *title;
+    char *icon_path;
+    char *icon_selected_path;
+    char *cmd;
+} EntryInfo;
+
+// Slot of a string table
+typedef struct {
+    const char *key; // NULL if the slot is empty
+    int index;
+} StringSlot;
+
+// Open addressing hash table from strings to the indices of an array,
+// the keys are owned by the array
+typedef struct {
+    StringSlot *slots;
+    Uint32 mask;
+    Uint32 count;
+} StringTable;
+
+// File found in the directory of a directory menu
+typedef struct {
+    char *path;
+    char *icon_path; // NULL if no matching icon was found
+} DirectoryFile;
+
+// Source of the entries of a menu that lists the files of a directory
+typedef struct {
+    char *directory;
+    char *command; // Command template, %f is replaced by the path of the file and %n by its name
+    char *icon_directory;
+    char *default_icon;
+    char *extensions;
+    unsigned int first_entry; // Entries before this one are defined in the config file
+    Uint32 hash; // Identifies the settings the index was built with
+    SDL_Thread *scan_thread;
+    SDL_mutex *mutex;
+    SDL_atomic_t quit;
+    bool scan_complete;
+    bool modified; // The files found differ from the entries loaded from the index
+    DirectoryFile *pending; // Files found by the scan that are not in the menu yet
+    int num_pending;
+    int max_pending;
+    DirectoryFile *files; // Every file found by the scan, sorted once the scan is complete
+    int num_files;
+    int max_files;
+    DirectoryFile *index_files; // Files stored in the index by a previous run
+    int num_index_files;
+    int num_index_matches;
+    StringTable index_table; // Paths of the index files
+} DirectorySource;
+
+// Other menus shown as stacked rows of a menu, e.g. for a home screen
+typedef struct {
+    char *names; // Names of the menus separated by semicolons, until they are resolved
+    struct menu **menus;
+    unsigned int num_rows;
+    unsigned int position; // Row with the highlight
+    unsigned int first; // First visible row
+} MenuRows;
+
+// Linked list for menus, the entries are stored in arrays
 typedef struct menu {
     char         *name;
     unsigned int num_entries;
-    bool         rendered;
-    unsigned int page;
+    unsigned int max_entries;
+    unsigned int page; // Page of a single row layout, first visible row of a grid
     unsigned int highlight_position;
-    Entry        *first_entry;
-    Entry        *root_entry;
-    Entry        *last_selected_entry;
+    unsigned int load_start; // Range of entries queued for loading
+    unsigned int load_end;
+    unsigned int num_jobs; // Loads of entries whose completion hasn't run yet
+    Uint32       last_visit; // Ticks when the menu was last shown, for the eviction of its textures
+    Entry        *entries;
+    EntryInfo    *entry_info;
+    DirectorySource *source; // Lists the files of a directory, NULL if the entries are all in the config file
+    MenuRows     *rows; // Menus shown as rows instead of entries, NULL for a menu of entries
     struct menu  *next;
     struct menu  *back;
 } Menu;
 
+// Icons and title of an entry, loaded in a worker thread
+typedef struct {
+    Menu *menu;
+    unsigned int index;
+    const char *title_text;
+    char *source_title; // Title with the values of data sources, NULL if the title has none
+    Uint32 sources_version; // Sources version of the values in the title
+    Icon *icon; // Icons loaded by this job, NULL if loaded by another entry
+    Icon *icon_selected;
+    SDL_Surface *icon_surface;
+    SDL_Surface *icon_selected_surface;
+    bool render_title;
+    SDL_Surface *title;
+    SDL_Rect text_rect;
+    int title_height;
+    bool done;
+} EntryLoad;
+
 typedef struct gamepad {
     SDL_GameController *controller;
     int device_index;
@@ -196,18 +320,68 @@ typedef struct {
     int screen_height;
     int screen_margin;
     int font_height;
-    int x_margin; // Distance between left edge of screen and x coordinate of root_entry icon
-    int y_margin; // Distance between top edge of screen and y coordinate of all entry icons
+    int x_margin; // Distance between left edge of screen and x coordinate of the first icon of the page
+    int y_margin; // Distance between top edge of screen and y coordinate of the icons of the first row
     int x_advance; // Distance between icon x coordinate of adjacent entries
+    int y_advance; // Distance between icon y coordinate of adjacent rows
     int num_buttons; // Number of buttons shown on the screen
 } Geometry;
 
+// Easing curves for animations
+typedef enum {
+    EASING_LINEAR,
+    EASING_EASE_IN_OUT,
+    EASING_EASE_OUT
+} Easing;
+
+// Time-based animation of a value
+typedef struct {
+    float *value;
+    float start;
+    float end;
+    Uint32 start_ticks;
+    Uint32 duration;
+    Easing easing;
+    void (*callback)(void *data);
+    void *data;
+    bool active;
+} Animation;
+
 // Struct for highlight 
 typedef struct {
     SDL_Texture *texture;
     SDL_Rect rect;
+    float x;
+    float y;
+    Animation movement;
+    Animation vertical_movement;
 } Highlight;
 
+// Slide of the entries of a menu from one page to the next, the
+// previous page is drawn a page width away from the new one
+typedef struct {
+    Menu *menu;
+    unsigned int page; // Page that slides off the screen
+    float offset; // Horizontal offset of the new page from its place
+    float distance; // Distance between the previous and the new page
+    Animation animation;
+} PageScroll;
+
+// Query of the type-ahead search and its rendered prompt
+typedef struct {
+    char query[MAX_SEARCH_QUERY_BYTES];
+    size_t length;
+    Menu *origin; // Menu shown before the search started
+    SDL_Texture *texture;
+    SDL_Rect rect;
+} Search;
+
+// Status widget, a line of text with the values of data sources
+typedef struct {
+    SDL_Texture *texture;
+    SDL_Rect rect;
+} Status;
+
 //Struct for scroll indicators
 typedef struct {
     SDL_Texture *texture;
@@ -215,23 +389,100 @@ typedef struct {
     SDL_Rect rect_left;
 } Scroll;
 
+// Image file formats that can be probed without decoding
+typedef enum {
+    IMAGE_FORMAT_UNKNOWN,
+    IMAGE_FORMAT_PNG,
+    IMAGE_FORMAT_JPEG,
+    IMAGE_FORMAT_WEBP
+} ImageFormat;
+
+typedef enum {
+    IMAGE_STATUS_PENDING,
+    IMAGE_STATUS_VALID,
+    IMAGE_STATUS_INVALID
+} ImageStatus;
+
+// Header information of an image file
+typedef struct {
+    Sint64 mtime;
+    Sint64 size;
+    Sint32 width;
+    Sint32 height;
+    Uint8  format;
+    Uint8  orientation; // EXIF orientation, 1 is upright
+    Uint8  status;
+} ImageInfo;
+
+// Slideshow image
+typedef struct {
+    char      *path; // NULL if the image was removed
+    ImageInfo info;
+} SlideshowImage;
+
+// Random permutation of indices for shuffling
+typedef struct {
+    Uint32 size;
+    Uint32 half_bits;
+    Uint32 keys[PERMUTATION_ROUNDS];
+} Permutation;
+
+// Pan and zoom motion of a slideshow image
+typedef struct {
+    Uint32 start_ticks;
+    Uint32 duration;
+    float start_zoom;
+    float end_zoom;
+    SDL_FPoint start_pan; // Position within the space the zoom leaves free, from 0 to 1
+    SDL_FPoint end_pan;
+} PanZoom;
+
 // Slideshow
 typedef struct {
-    char **images;
-    int *order;
+    SlideshowImage *images;
+    StringTable paths; // Indices of the images by path
+    int *free_images; // Slots of removed images, reused by new images
+    int num_free_images;
+    int max_free_images;
+    Permutation order; // Reshuffled at the start of every cycle
+    Uint64 random_state;
     int i;
     int num_images;
+    int num_available;
+    int max_images;
+    SDL_mutex *mutex;
+    SDL_cond *scan_cond;
+    SDL_Thread *scan_thread;
+    bool scan_complete;
+    SDL_cond *probe_cond;
+    SDL_Thread *probe_threads[MAX_PROBE_THREADS];
+    int num_probe_threads;
+    int *probe_queue;
+    int num_probes;
+    int max_probes;
+    int num_pending; // Images waiting for or being probed
+    bool index_modified;
+    SDL_atomic_t quit;
     float transition_alpha;
-    float transition_change_rate;
+    Animation transition;
     SDL_Surface *transition_surface;
+    int load_attempts; // Images tried to load the prefetched image
     SDL_Texture *transition_texture;
+    SDL_Texture *next_texture; // Prefetched next image
+    SDL_Texture *history[MAX_SLIDESHOW_HISTORY]; // Recently shown images, oldest first
+    int history_length;
+    int history_position;
+    Sint64 texture_bytes;
+    PanZoom background_motion;
+    PanZoom transition_motion;
+    Uint64 motion_random_state;
 } Slideshow;
 
 // Screensaver
 typedef struct {
     float alpha;
     float alpha_end_value;
-    float transition_change_rate;
+    Animation transition;
     SDL_Texture *texture;
 } Screensaver;
 
@@ -239,6 +490,7 @@ typedef struct {
 typedef struct {
     char *default_menu;
     unsigned int max_buttons;
+    unsigned int rows;
     bool vsync;
     int fps_limit;
     Uint32 application_timeout;
@@ -250,6 +502,7 @@ typedef struct {
     bool background_overlay;
     SDL_Color background_overlay_color;
     char background_overlay_opacity[PERCENT_MAX_CHARS];
+    unsigned int image_cache_size;
     Uint16 icon_size;
     int icon_spacing;
     char icon_spacing_str[PERCENT_MAX_CHARS];
@@ -279,6 +532,8 @@ typedef struct {
     char scroll_indicator_opacity[PERCENT_MAX_CHARS];
     bool wrap_entries;
     bool reset_on_back;
+    unsigned int prefetch_size;
+    unsigned int texture_budget;
     bool mouse_select;
     bool inhibit_os_screensaver;
     char *startup_cmd;
@@ -309,8 +564,13 @@ typedef struct {
     TimeFormat clock_time_format;
     DateFormat clock_date_format;
     bool clock_include_weekday;
+    bool status_enabled;
+    char *status_text;
+    Alignment status_alignment;
     Uint32 slideshow_image_duration;
     Uint32 slideshow_transition_time;
+    unsigned int slideshow_history_size;
+    bool slideshow_pan_zoom;
 } Config;
 
 void quit_slideshow(void);
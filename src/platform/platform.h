@@ -3,13 +3,36 @@
 #else
 #define FILE_MODE_WRITE "w"
 #endif
+#define COMMAND_OUTPUT_BUFFER_BYTES 256
+#define COMMAND_TIMEOUT 5000 // Milliseconds a data source command may run before it is killed
+#define COMMAND_POLL_INTERVAL 10
+
+// File information
+typedef struct {
+    char *path;
+    Sint64 mtime;
+    Sint64 size;
+} FileInfo;
+
+// Function called for every file found by scan_files, returns false to stop the scan
+typedef bool (*FileCallback)(const char *path, void *data);
 
 // Abstracted platform function prototypes
 bool file_exists(const char *path);
 bool directory_exists(const char *path);
+void make_directory(const char *directory);
+bool get_file_info(const char *path, FileInfo *info);
+size_t list_files(const char *directory, FileInfo **files);
+void scan_files(const char *directory, FileCallback callback, void *data);
+void *map_file(const char *path, size_t *size);
+void unmap_file(void *data, size_t size);
+void touch_file(const char *path);
+bool replace_file(const char *old_path, const char *new_path);
+bool get_canonical_path(const char *path, char *buffer, size_t bytes);
 void get_region(char *buffer);
-void scan_slideshow_directory(Slideshow *slideshow, const char *directory);
+void monitor_slideshow_directory(Slideshow *slideshow, const char *directory);
 bool start_process(char *cmd, bool application);
+bool read_command_output(const char *cmd, char *buffer, size_t bytes);
 bool process_running();
 void scmd_shutdown(void);
 void scmd_restart(void);
@@ -17,7 +40,6 @@ void scmd_sleep(void);
 
 // Linux-specific function prototypes
 #ifdef __unix__
-void make_directory(const char *directory);
 void print_usage(void);
 #endif
 
@@ -1,10 +1,20 @@
+#define _GNU_SOURCE // pipe2
 #include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <string.h>
+#include <errno.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <dirent.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <signal.h>
+#include <poll.h>
+#include <sys/inotify.h>
 #include <SDL.h>
 #include "../external/ini.h"
 #include "../launcher.h"
@@ -13,12 +23,15 @@
 #include "../util.h"
 #include "../debug.h"
 #include "platform.h"
-#include "slideshow.h"
+#include "../slideshow.h"
 
 static int desktop_handler(void *user, const char *section, const char *name, const char *value);
 static void strip_field_codes(char *cmd);
 static bool ends_with(const char *string, const char *phrase);
-static int image_filter(const struct dirent *file);
+static void scan_directory(Slideshow *slideshow, const char *directory, Watcher *watcher);
+static void add_watch(Watcher *watcher, const char *directory);
+static void remove_watches(Watcher *watcher, const char *directory);
+static void handle_inotify_event(Slideshow *slideshow, Watcher *watcher, const struct inotify_event *event);
 
 pid_t child_pid;
 
@@ -81,6 +94,172 @@ void make_directory(const char *directory)
     mkdir(buffer, S_IRWXU);
 }
 
+// A function to get the modification time and size of a file
+bool get_file_info(const char *path, FileInfo *info)
+{
+    struct stat file;
+    if (stat(path, &file) || !S_ISREG(file.st_mode))
+        return false;
+    info->path = NULL;
+    info->mtime = (Sint64) file.st_mtime;
+    info->size = (Sint64) file.st_size;
+    return true;
+}
+
+// A function to list the regular files in a directory
+size_t list_files(const char *directory, FileInfo **files)
+{
+    DIR *dir = opendir(directory);
+    if (dir == NULL)
+        return 0;
+    size_t num_files = 0;
+    struct dirent *entry;
+    char file_path[MAX_PATH_CHARS + 1];
+    FileInfo info;
+    while ((entry = readdir(dir)) != NULL) {
+        join_paths(file_path, sizeof(file_path), 2, directory, entry->d_name);
+        if (!get_file_info(file_path, &info))
+            continue;
+        info.path = strdup(file_path);
+        *files = realloc(*files, (num_files + 1) * sizeof(FileInfo));
+        (*files)[num_files++] = info;
+    }
+    closedir(dir);
+    return num_files;
+}
+
+// A function to pass the regular files of a directory to a callback
+// while the directory is read
+void scan_files(const char *directory, FileCallback callback, void *data)
+{
+    DIR *dir = opendir(directory);
+    if (dir == NULL)
+        return;
+    struct dirent *entry;
+    char file_path[MAX_PATH_CHARS + 1];
+    FileInfo info;
+    while ((entry = readdir(dir)) != NULL) {
+        join_paths(file_path, sizeof(file_path), 2, directory, entry->d_name);
+        if (get_file_info(file_path, &info) && !callback(file_path, data))
+            break;
+    }
+    closedir(dir);
+}
+
+// A function to map a file read-only into memory
+void *map_file(const char *path, size_t *size)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd == -1)
+        return NULL;
+    struct stat file;
+    if (fstat(fd, &file) || file.st_size == 0) {
+        close(fd);
+        return NULL;
+    }
+    void *data = mmap(NULL, (size_t) file.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return NULL;
+    *size = (size_t) file.st_size;
+    return data;
+}
+
+// A function to unmap a file from memory
+void unmap_file(void *data, size_t size)
+{
+    munmap(data, size);
+}
+
+// A function to update the modification time of a file
+void touch_file(const char *path)
+{
+    utimensat(AT_FDCWD, path, NULL, 0);
+}
+
+// A function to atomically replace a file with another
+bool replace_file(const char *old_path, const char *new_path)
+{
+    return rename(old_path, new_path) == 0;
+}
+
+// A function to get the absolute path of a file with all links resolved
+bool get_canonical_path(const char *path, char *buffer, size_t bytes)
+{
+    char resolved_path[PATH_MAX];
+    if (realpath(path, resolved_path) == NULL)
+        return false;
+    copy_string(buffer, resolved_path, bytes);
+    return true;
+}
+
+// A function to run a shell command and get the first line of its output. A
+// command that runs longer than the timeout is killed together with the
+// processes it started, so it can't block the worker thread.
+bool read_command_output(const char *cmd, char *buffer, size_t bytes)
+{
+    // The pipe is closed on exec, so commands that run at the same time and
+    // launched applications don't keep each other's output open
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) == -1)
+        return false;
+    pid_t pid = fork();
+    switch (pid) {
+        case -1:
+            close(fds[0]);
+            close(fds[1]);
+            return false;
+
+        // Child process, only async-signal-safe functions may be called
+        // since the parent has other threads
+        case 0:
+            setpgid(0, 0);
+            dup2(fds[1], STDOUT_FILENO);
+            close(fds[0]);
+            close(fds[1]);
+            execl("/bin/sh", "sh", "-c", cmd, (char*) NULL);
+            _exit(127);
+    }
+    setpgid(pid, 0);
+    close(fds[1]);
+
+    // Read the whole output so the command isn't stopped by a broken pipe,
+    // then wait for the command to exit
+    Uint32 deadline = SDL_GetTicks() + COMMAND_TIMEOUT;
+    char chunk[COMMAND_OUTPUT_BUFFER_BYTES];
+    size_t length = 0;
+    bool line_complete = false;
+    bool output_closed = false;
+    bool exited = false;
+    int remaining;
+    while (!exited && (remaining = (int) (deadline - SDL_GetTicks())) > 0) {
+        if (output_closed) {
+            exited = waitpid(pid, NULL, WNOHANG) != 0;
+            if (!exited)
+                SDL_Delay((Uint32) MIN(remaining, COMMAND_POLL_INTERVAL));
+            continue;
+        }
+        struct pollfd output = {.fd = fds[0], .events = POLLIN};
+        if (poll(&output, 1, remaining) <= 0)
+            continue;
+        ssize_t count = read(fds[0], chunk, sizeof(chunk));
+        if (count == 0 || (count == -1 && errno != EINTR))
+            output_closed = true;
+        for (ssize_t i = 0; i < count && !line_complete; i++) {
+            buffer[length++] = chunk[i];
+            line_complete = chunk[i] == '\n' || length == bytes - 1;
+        }
+    }
+    buffer[length] = '\0';
+    close(fds[0]);
+    if (!exited) {
+        log_error("Command '%s' did not finish within %i ms", cmd, COMMAND_TIMEOUT);
+        kill(-pid, SIGKILL);
+        waitpid(pid, NULL, 0);
+    }
+    return exited;
+}
+
 // A function to determine if a string ends with a phrase
 static bool ends_with(const char *string, const char *phrase)
 {
@@ -184,33 +363,136 @@ bool process_running()
     return true;
 }
 
-// A function to determine if a file is an image file
-int image_filter(const struct dirent *file)
+// A function to add an inotify watch for a directory
+static void add_watch(Watcher *watcher, const char *directory)
 {
-    size_t len_file = strlen(file->d_name);
-    size_t len_extension;
-    for (size_t i = 0; i < NUM_IMAGE_EXTENSIONS; i++) {
-        len_extension = strlen(extensions[i]);
-        if (len_file > len_extension && 
-        !strcmp(file->d_name + len_file - len_extension, extensions[i]))
-            return 1;
+    if (watcher->fd == -1)
+        return;
+    int wd = inotify_add_watch(watcher->fd, directory, INOTIFY_MASK);
+    if (wd == -1) {
+        log_error("Could not watch slideshow directory %s", directory);
+        return;
+    }
+    watcher->watches = realloc(watcher->watches, (watcher->num_watches + 1) * sizeof(Watch));
+    watcher->watches[watcher->num_watches].wd = wd;
+    watcher->watches[watcher->num_watches].path = strdup(directory);
+    watcher->num_watches++;
+}
+
+// A function to remove the inotify watches of a directory and its subdirectories
+static void remove_watches(Watcher *watcher, const char *directory)
+{
+    size_t length = strlen(directory);
+    for (size_t i = 0; i < watcher->num_watches; i++) {
+        Watch *watch = watcher->watches + i;
+        if (!strncmp(watch->path, directory, length) &&
+        (watch->path[length] == '\0' || watch->path[length] == '/')) {
+            inotify_rm_watch(watcher->fd, watch->wd);
+            free(watch->path);
+            watcher->watches[i--] = watcher->watches[--watcher->num_watches];
+        }
     }
-    return 0;
 }
 
-// A function to scan a directory for images
-void scan_slideshow_directory(Slideshow *slideshow, const char *directory)
+// A function to recursively scan a directory for images
+static void scan_directory(Slideshow *slideshow, const char *directory, Watcher *watcher)
 {
-    struct dirent **files;
-    slideshow->num_images = scandir(directory, &files, image_filter, NULL);
-    slideshow->images = malloc((size_t) slideshow->num_images * sizeof(char*));
+    // Watch the directory before reading it so no new files are missed
+    add_watch(watcher, directory);
+    DIR *dir = opendir(directory);
+    if (dir == NULL)
+        return;
+
+    struct dirent *file;
+    struct stat info;
     char file_path[MAX_PATH_CHARS + 1];
-    for (int i = 0; i < slideshow->num_images; i++) {
-        join_paths(file_path, sizeof(file_path), 2, directory, files[i]->d_name);
-        slideshow->images[i] = strdup(file_path);
-        free(files[i]);
+    while ((file = readdir(dir)) != NULL && !slideshow_quit_requested(slideshow)) {
+        if (file->d_name[0] == '.')
+            continue;
+        join_paths(file_path, sizeof(file_path), 2, directory, file->d_name);
+        bool is_directory = file->d_type == DT_DIR;
+        if (file->d_type == DT_UNKNOWN)
+            is_directory = !lstat(file_path, &info) && S_ISDIR(info.st_mode);
+
+        // Symbolic links to directories are not followed to avoid loops
+        if (is_directory)
+            scan_directory(slideshow, file_path, watcher);
+        else if (is_image_file(file->d_name))
+            add_slideshow_image(slideshow, file_path);
+    }
+    closedir(dir);
+}
+
+// A function to update the slideshow images from a change in the directory tree
+static void handle_inotify_event(Slideshow *slideshow, Watcher *watcher, const struct inotify_event *event)
+{
+    if (!event->len || event->name[0] == '.')
+        return;
+    Watch *watch = NULL;
+    for (size_t i = 0; i < watcher->num_watches && watch == NULL; i++) {
+        if (watcher->watches[i].wd == event->wd)
+            watch = watcher->watches + i;
+    }
+    if (watch == NULL)
+        return;
+
+    char path[MAX_PATH_CHARS + 1];
+    join_paths(path, sizeof(path), 2, watch->path, event->name);
+    if (event->mask & IN_ISDIR) {
+        if (event->mask & (IN_CREATE | IN_MOVED_TO))
+            scan_directory(slideshow, path, watcher);
+        else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+            remove_watches(watcher, path);
+            remove_slideshow_images(slideshow, path);
+        }
     }
-    free(files);
+    else if (is_image_file(event->name)) {
+        // Files that were overwritten are updated in place
+        if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+            add_slideshow_image(slideshow, path);
+            log_debug("Added slideshow image %s", path);
+        }
+        else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+            remove_slideshow_images(slideshow, path);
+    }
+}
+
+// A function to recursively scan the slideshow directory for images,
+// then watch it for changes until the slideshow quits
+void monitor_slideshow_directory(Slideshow *slideshow, const char *directory)
+{
+    Watcher watcher = {
+        .fd = inotify_init1(IN_CLOEXEC),
+        .watches = NULL,
+        .num_watches = 0
+    };
+    if (watcher.fd == -1)
+        log_error("Could not initialize inotify, new slideshow images will not be detected");
+    scan_directory(slideshow, directory, &watcher);
+    finish_slideshow_scan(slideshow);
+
+    // Process directory changes
+    char buffer[INOTIFY_BUFFER_SIZE] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+    struct pollfd fds = { .fd = watcher.fd, .events = POLLIN };
+    while (watcher.fd != -1 && !slideshow_quit_requested(slideshow)) {
+        if (poll(&fds, 1, SLIDESHOW_WATCH_PERIOD) <= 0)
+            continue;
+        ssize_t length = read(watcher.fd, buffer, sizeof(buffer));
+        if (length <= 0)
+            continue;
+        const struct inotify_event *event;
+        for (char *p = buffer; p < buffer + length; p += sizeof(struct inotify_event) + event->len) {
+            event = (const struct inotify_event*) p;
+            handle_inotify_event(slideshow, &watcher, event);
+        }
+    }
+
+    // Clean up
+    for (size_t i = 0; i < watcher.num_watches; i++)
+        free(watcher.watches[i].path);
+    free(watcher.watches);
+    if (watcher.fd != -1)
+        close(watcher.fd);
 }
 
 void get_region(char *buffer)
@@ -9,8 +9,23 @@
 #define DESKTOP_SECTION_HEADER_ACTION "Desktop Action %s"
 #define KEY_EXEC "Exec"
 #define MAX_INI_SECTION 100
+#define INOTIFY_MASK (IN_CREATE | IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE)
+#define INOTIFY_BUFFER_SIZE 4096
 
 typedef struct {
     char section[MAX_INI_SECTION + 1];
     char *exec;
 } Desktop;
+
+// Inotify watch of a slideshow directory
+typedef struct {
+    int wd;
+    char *path;
+} Watch;
+
+// Inotify instance watching the slideshow directory tree
+typedef struct {
+    int fd;
+    Watch *watches;
+    size_t num_watches;
+} Watcher;
@@ -12,7 +12,9 @@
 #include "platform.h"
 #include "../util.h"
 #include "../debug.h"
-#include "slideshow.h"
+#include "../slideshow.h"
+
+#define DIRECTORY_CHANGES_BUFFER_SIZE 16384
 
 static void parse_command(char *cmd, char *file, size_t file_size, char **params);
 static char *path_basename(const char *path);
@@ -20,6 +22,9 @@ static bool process_running_name(const char *target_process);
 static bool is_browser(const char *exe_basename);
 static UINT sdl_to_win32_keycode(SDL_Keycode keycode);
 static bool get_shutdown_privilege(void);
+static Sint64 file_time_to_unix(FILETIME *time);
+static void scan_directory(Slideshow *slideshow, const char *directory);
+static void handle_directory_changes(Slideshow *slideshow, const char *directory, FILE_NOTIFY_INFORMATION *info);
 
 extern Config config;
 extern SDL_SysWMinfo wm_info;
@@ -187,32 +192,386 @@ bool process_running()
     return status == WAIT_OBJECT_0 ? false : true;
 }
 
-// A function to scan the slideshow directory for image files
-void scan_slideshow_directory(Slideshow *slideshow, const char *directory)
+// A function to run a command with the command interpreter and get the
+// first line of its output. A command that runs longer than the timeout is
+// killed together with the processes it started, so it can't block the
+// worker thread.
+bool read_command_output(const char *cmd, char *buffer, size_t bytes)
+{
+    SECURITY_ATTRIBUTES attributes = {
+        .nLength = sizeof(SECURITY_ATTRIBUTES),
+        .lpSecurityDescriptor = NULL,
+        .bInheritHandle = TRUE
+    };
+    HANDLE output_read;
+    HANDLE output_write;
+    if (!CreatePipe(&output_read, &output_write, &attributes, 0))
+        return false;
+    SetHandleInformation(output_read, HANDLE_FLAG_INHERIT, 0);
+
+    // Only the write end of this pipe is inherited, so commands that start
+    // at the same time don't keep each other's output open
+    SIZE_T list_bytes = 0;
+    InitializeProcThreadAttributeList(NULL, 1, 0, &list_bytes);
+    LPPROC_THREAD_ATTRIBUTE_LIST attribute_list = malloc(list_bytes);
+    BOOL initialized = attribute_list != NULL &&
+                       InitializeProcThreadAttributeList(attribute_list, 1, 0, &list_bytes);
+    if (!initialized || !UpdateProcThreadAttribute(attribute_list,
+                             0,
+                             PROC_THREAD_ATTRIBUTE_HANDLE_LIST,
+                             &output_write,
+                             sizeof(HANDLE),
+                             NULL,
+                             NULL
+                         )) {
+        if (initialized)
+            DeleteProcThreadAttributeList(attribute_list);
+        free(attribute_list);
+        CloseHandle(output_read);
+        CloseHandle(output_write);
+        return false;
+    }
+
+    // Start the command suspended in a job, so the processes it
+    // starts can be terminated with it
+    char command_line[MAX_PATH_CHARS + 1];
+    snprintf(command_line, sizeof(command_line), "cmd.exe /c %s", cmd);
+    STARTUPINFOEXA startup_info = {
+        .StartupInfo = {
+            .cb = sizeof(STARTUPINFOEXA),
+            .dwFlags = STARTF_USESTDHANDLES,
+            .hStdInput = NULL,
+            .hStdOutput = output_write,
+            .hStdError = NULL
+        },
+        .lpAttributeList = attribute_list
+    };
+    PROCESS_INFORMATION process_info;
+    HANDLE job = CreateJobObjectA(NULL, NULL);
+    BOOL created = job != NULL && CreateProcessA(NULL,
+                                      command_line,
+                                      NULL,
+                                      NULL,
+                                      TRUE,
+                                      CREATE_NO_WINDOW | CREATE_SUSPENDED | EXTENDED_STARTUPINFO_PRESENT,
+                                      NULL,
+                                      NULL,
+                                      &startup_info.StartupInfo,
+                                      &process_info
+                                  );
+    CloseHandle(output_write);
+    DeleteProcThreadAttributeList(attribute_list);
+    free(attribute_list);
+    if (!created) {
+        if (job != NULL)
+            CloseHandle(job);
+        CloseHandle(output_read);
+        return false;
+    }
+    AssignProcessToJobObject(job, process_info.hProcess);
+    ResumeThread(process_info.hThread);
+    CloseHandle(process_info.hThread);
+
+    // Read the whole output so the command isn't stopped by a broken pipe,
+    // then wait for the command to exit
+    Uint32 deadline = SDL_GetTicks() + COMMAND_TIMEOUT;
+    char chunk[COMMAND_OUTPUT_BUFFER_BYTES];
+    size_t length = 0;
+    bool line_complete = false;
+    bool output_closed = false;
+    bool exited = false;
+    int remaining;
+    while (!exited && (remaining = (int) (deadline - SDL_GetTicks())) > 0) {
+        DWORD available = 0;
+        if (output_closed || !PeekNamedPipe(output_read, NULL, 0, NULL, &available, NULL)) {
+            output_closed = true;
+            exited = WaitForSingleObject(process_info.hProcess, (DWORD) remaining) == WAIT_OBJECT_0;
+            continue;
+        }
+        if (!available) {
+            Sleep((DWORD) MIN(remaining, COMMAND_POLL_INTERVAL));
+            continue;
+        }
+        DWORD count = 0;
+        if (!ReadFile(output_read, chunk, (DWORD) MIN(available, sizeof(chunk)), &count, NULL))
+            output_closed = true;
+        for (DWORD i = 0; i < count && !line_complete; i++) {
+            buffer[length++] = chunk[i];
+            line_complete = chunk[i] == '\n' || length == bytes - 1;
+        }
+    }
+    buffer[length] = '\0';
+    CloseHandle(output_read);
+    if (!exited) {
+        log_error("Command '%s' did not finish within %i ms", cmd, COMMAND_TIMEOUT);
+        TerminateJobObject(job, 1);
+    }
+    CloseHandle(process_info.hProcess);
+    CloseHandle(job);
+    return exited;
+}
+
+// A function to make a directory, including any intermediate
+// directories if necessary
+void make_directory(const char *directory)
+{
+    char buffer[MAX_PATH_CHARS + 1];
+    copy_string(buffer, directory, sizeof(buffer));
+    size_t length = strlen(buffer);
+    if (buffer[length - 1] == '\\' || buffer[length - 1] == '/')
+        buffer[length - 1] = '\0';
+    for (char *i = buffer + 1; *i != '\0'; i++) {
+        if ((*i == '\\' || *i == '/') && *(i - 1) != ':') {
+            char c = *i;
+            *i = '\0';
+            CreateDirectoryA(buffer, NULL);
+            *i = c;
+        }
+    }
+    CreateDirectoryA(buffer, NULL);
+}
+
+// A function to convert a Windows file time to a Unix timestamp
+static Sint64 file_time_to_unix(FILETIME *time)
+{
+    ULARGE_INTEGER value;
+    value.LowPart = time->dwLowDateTime;
+    value.HighPart = time->dwHighDateTime;
+    return (Sint64) (value.QuadPart / 10000000ULL) - 11644473600LL;
+}
+
+// A function to get the modification time and size of a file
+bool get_file_info(const char *path, FileInfo *info)
+{
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExA(path, GetFileExInfoStandard, &data) ||
+    data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+        return false;
+    info->path = NULL;
+    info->mtime = file_time_to_unix(&data.ftLastWriteTime);
+    info->size = ((Sint64) data.nFileSizeHigh << 32) | data.nFileSizeLow;
+    return true;
+}
+
+// A function to list the regular files in a directory
+size_t list_files(const char *directory, FileInfo **files)
 {
     WIN32_FIND_DATAA data;
-    HANDLE handle;
     char file_search[MAX_PATH_CHARS + 1];
-    char file_output[MAX_PATH_CHARS + 1];
-    char extension[10];
-
-    // Generate a wildcard file search string for all supported image file extensions
-    for (int i = 0; i < NUM_IMAGE_EXTENSIONS; i++) {
-        copy_string(extension, "*", sizeof(extension));
-        strcat(extension, extensions[i]);
-        join_paths(file_search, sizeof(file_search), 2, directory, extension);
-
-        // Store every result into the slideshow struct
-        handle = FindFirstFileA(file_search, &data);
-        if (handle != INVALID_HANDLE_VALUE) {
-            do {
-                join_paths(file_output, sizeof(file_output), 2, directory, data.cFileName);
-                slideshow->images = realloc(slideshow->images, (slideshow->num_images + 1) * sizeof(char*));
-                slideshow->images[slideshow->num_images] = strdup(file_output);
-                slideshow->num_images++;
-            } while (FindNextFileA(handle, &data) != 0);
+    char file_path[MAX_PATH_CHARS + 1];
+    join_paths(file_search, sizeof(file_search), 2, directory, "*");
+    HANDLE handle = FindFirstFileA(file_search, &data);
+    if (handle == INVALID_HANDLE_VALUE)
+        return 0;
+    size_t num_files = 0;
+    do {
+        if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            continue;
+        join_paths(file_path, sizeof(file_path), 2, directory, data.cFileName);
+        *files = realloc(*files, (num_files + 1) * sizeof(FileInfo));
+        (*files)[num_files].path = strdup(file_path);
+        (*files)[num_files].mtime = file_time_to_unix(&data.ftLastWriteTime);
+        (*files)[num_files].size = ((Sint64) data.nFileSizeHigh << 32) | data.nFileSizeLow;
+        num_files++;
+    } while (FindNextFileA(handle, &data) != 0);
+    FindClose(handle);
+    return num_files;
+}
+
+// A function to pass the regular files of a directory to a callback
+// while the directory is read
+void scan_files(const char *directory, FileCallback callback, void *data)
+{
+    WIN32_FIND_DATAA find_data;
+    char file_search[MAX_PATH_CHARS + 1];
+    char file_path[MAX_PATH_CHARS + 1];
+    join_paths(file_search, sizeof(file_search), 2, directory, "*");
+    HANDLE handle = FindFirstFileA(file_search, &find_data);
+    if (handle == INVALID_HANDLE_VALUE)
+        return;
+    do {
+        if (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            continue;
+        join_paths(file_path, sizeof(file_path), 2, directory, find_data.cFileName);
+        if (!callback(file_path, data))
+            break;
+    } while (FindNextFileA(handle, &find_data) != 0);
+    FindClose(handle);
+}
+
+// A function to map a file read-only into memory
+void *map_file(const char *path, size_t *size)
+{
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return NULL;
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+        CloseHandle(file);
+        return NULL;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (mapping == NULL)
+        return NULL;
+    void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (data == NULL)
+        return NULL;
+    *size = (size_t) file_size.QuadPart;
+    return data;
+}
+
+// A function to unmap a file from memory
+void unmap_file(void *data, size_t size)
+{
+    (void) size;
+    UnmapViewOfFile(data);
+}
+
+// A function to update the modification time of a file
+void touch_file(const char *path)
+{
+    HANDLE file = CreateFileA(path, FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return;
+    FILETIME time;
+    GetSystemTimeAsFileTime(&time);
+    SetFileTime(file, NULL, NULL, &time);
+    CloseHandle(file);
+}
+
+// A function to atomically replace a file with another
+bool replace_file(const char *old_path, const char *new_path)
+{
+    return MoveFileExA(old_path, new_path, MOVEFILE_REPLACE_EXISTING) ? true : false;
+}
+
+// A function to get the absolute path of a file, lowercase
+// because paths are case insensitive on Windows
+bool get_canonical_path(const char *path, char *buffer, size_t bytes)
+{
+    DWORD length = GetFullPathNameA(path, (DWORD) bytes, buffer, NULL);
+    if (length == 0 || length >= bytes)
+        return false;
+    CharLowerA(buffer);
+    return true;
+}
+
+// A function to recursively scan a directory for image files
+static void scan_directory(Slideshow *slideshow, const char *directory)
+{
+    WIN32_FIND_DATAA data;
+    char file_search[MAX_PATH_CHARS + 1];
+    char file_path[MAX_PATH_CHARS + 1];
+    join_paths(file_search, sizeof(file_search), 2, directory, "*");
+    HANDLE handle = FindFirstFileA(file_search, &data);
+    if (handle == INVALID_HANDLE_VALUE)
+        return;
+    do {
+        if (data.cFileName[0] == '.')
+            continue;
+        join_paths(file_path, sizeof(file_path), 2, directory, data.cFileName);
+
+        // Reparse points are not followed to avoid loops
+        if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+            if (!(data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT))
+                scan_directory(slideshow, file_path);
+        }
+        else if (is_image_file(data.cFileName))
+            add_slideshow_image(slideshow, file_path);
+    } while (FindNextFileA(handle, &data) != 0 && !slideshow_quit_requested(slideshow));
+    FindClose(handle);
+}
+
+// A function to update the slideshow images from a list of directory changes
+static void handle_directory_changes(Slideshow *slideshow, const char *directory, FILE_NOTIFY_INFORMATION *info)
+{
+    char name[MAX_PATH_CHARS + 1];
+    char path[MAX_PATH_CHARS + 1];
+    while (true) {
+        int length = WideCharToMultiByte(CP_ACP,
+                         0,
+                         info->FileName,
+                         (int) (info->FileNameLength / sizeof(WCHAR)),
+                         name,
+                         MAX_PATH_CHARS,
+                         NULL,
+                         NULL
+                     );
+        name[length] = '\0';
+        join_paths(path, sizeof(path), 2, directory, name);
+        switch (info->Action) {
+            case FILE_ACTION_ADDED:
+            case FILE_ACTION_RENAMED_NEW_NAME:
+                if (directory_exists(path))
+                    scan_directory(slideshow, path);
+                else if (is_image_file(path)) {
+                    add_slideshow_image(slideshow, path);
+                    log_debug("Added slideshow image %s", path);
+                }
+                break;
+
+            // Removing a directory removes every image inside it
+            case FILE_ACTION_REMOVED:
+            case FILE_ACTION_RENAMED_OLD_NAME:
+                remove_slideshow_images(slideshow, path);
+                break;
         }
+        if (!info->NextEntryOffset)
+            break;
+        info = (FILE_NOTIFY_INFORMATION*) ((char*) info + info->NextEntryOffset);
+    }
+}
+
+// A function to recursively scan the slideshow directory for images,
+// then watch it for changes until the slideshow quits
+void monitor_slideshow_directory(Slideshow *slideshow, const char *directory)
+{
+    DWORD buffer[DIRECTORY_CHANGES_BUFFER_SIZE / sizeof(DWORD)];
+    DWORD filter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME;
+    DWORD bytes;
+    OVERLAPPED overlapped = {0};
+    HANDLE handle = CreateFileA(directory,
+                        FILE_LIST_DIRECTORY,
+                        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                        NULL,
+                        OPEN_EXISTING,
+                        FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+                        NULL
+                    );
+
+    // Start watching before the scan so no new files are missed
+    overlapped.hEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+    bool watching = handle != INVALID_HANDLE_VALUE &&
+                    overlapped.hEvent != NULL &&
+                    ReadDirectoryChangesW(handle, buffer, sizeof(buffer), TRUE, filter, NULL, &overlapped, NULL);
+    if (!watching)
+        log_error("Could not watch slideshow directory, new slideshow images will not be detected");
+    scan_directory(slideshow, directory);
+    finish_slideshow_scan(slideshow);
+
+    // Process directory changes
+    while (watching && !slideshow_quit_requested(slideshow)) {
+        if (WaitForSingleObject(overlapped.hEvent, SLIDESHOW_WATCH_PERIOD) != WAIT_OBJECT_0)
+            continue;
+        if (!GetOverlappedResult(handle, &overlapped, &bytes, FALSE))
+            break;
+        if (bytes)
+            handle_directory_changes(slideshow, directory, (FILE_NOTIFY_INFORMATION*) buffer);
+        ResetEvent(overlapped.hEvent);
+        watching = ReadDirectoryChangesW(handle, buffer, sizeof(buffer), TRUE, filter, NULL, &overlapped, NULL);
+    }
+
+    // Clean up
+    if (watching) {
+        CancelIo(handle);
+        GetOverlappedResult(handle, &overlapped, &bytes, TRUE);
     }
+    if (overlapped.hEvent != NULL)
+        CloseHandle(overlapped.hEvent);
+    if (handle != INVALID_HANDLE_VALUE)
+        CloseHandle(handle);
 }
 
 // A function to get the 2 letter region code
@@ -0,0 +1,350 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <SDL.h>
+#include "launcher.h"
+#include <launcher_config.h>
+#include "search.h"
+#include "directory.h"
+#include "util.h"
+#include "debug.h"
+
+static void build_index(void);
+static void free_index(void);
+static bool is_searchable(const char *cmd);
+static void lowercase(char *string);
+static Uint32 get_trigram_key(const char *string);
+static Uint32 hash_trigram(Uint32 key);
+static SearchTrigram *find_trigram(Uint32 key);
+static int compare_titles(const void *a, const void *b);
+static int compare_postings(const void *a, const void *b);
+static void search_prefix(Menu *results, const char *query, size_t length);
+static void search_trigrams(Menu *results, const char *query, size_t length);
+static void add_result(Menu *results, Uint32 document);
+static void retire_results(void);
+
+extern Config config;
+
+static SearchIndex search_index = { NULL };
+static Menu *results             = NULL;
+static Menu **retired            = NULL;
+static int num_retired           = 0;
+static int max_retired           = 0;
+
+// Commands that only make sense in the menu they are defined in
+static const char *excluded_commands[] = {
+    SCMD_BACK,
+    SCMD_HOME,
+    SCMD_SEARCH
+};
+
+// A function to build the search index of the menus in the config file
+void init_search()
+{
+    build_index();
+}
+
+// A function to free the search index and all results menus
+void quit_search()
+{
+    free_index();
+    retire_results();
+    for (int i = 0; i < num_retired; i++)
+        free_menu(retired[i]);
+    free(retired);
+    retired = NULL;
+    num_retired = 0;
+    max_retired = 0;
+}
+
+// A function to determine if an entry with a command should be found by the search
+static bool is_searchable(const char *cmd)
+{
+    for (size_t i = 0; i < sizeof(excluded_commands) / sizeof(excluded_commands[0]); i++) {
+        if (MATCH(cmd, excluded_commands[i]))
+            return false;
+    }
+    return true;
+}
+
+// A function to convert the ASCII letters of a string to lowercase,
+// multibyte UTF-8 characters are matched exactly
+static void lowercase(char *string)
+{
+    for (char *p = string; *p != '\0'; p++)
+        *p = (char) SDL_tolower((unsigned char) *p);
+}
+
+// A function to pack the first three bytes of a string into a trigram key
+static Uint32 get_trigram_key(const char *string)
+{
+    return ((Uint32) (Uint8) string[0] << 16) | ((Uint32) (Uint8) string[1] << 8) | (Uint8) string[2];
+}
+
+// A function to spread the bytes of a trigram key over the table
+static Uint32 hash_trigram(Uint32 key)
+{
+    Uint32 hash = key * 0x9E3779B1;
+    return hash ^ (hash >> 16);
+}
+
+// A function to look up a trigram in the table, NULL if no title contains it
+static SearchTrigram *find_trigram(Uint32 key)
+{
+    for (Uint32 slot = hash_trigram(key) & search_index.trigram_mask;
+    search_index.trigrams[slot].key != 0;
+    slot = (slot + 1) & search_index.trigram_mask) {
+        if (search_index.trigrams[slot].key == key)
+            return search_index.trigrams + slot;
+    }
+    return NULL;
+}
+
+// A function to sort documents by their lowercase title
+static int compare_titles(const void *a, const void *b)
+{
+    return strcmp(search_index.titles + search_index.documents[*(const Uint32*) a].title,
+               search_index.titles + search_index.documents[*(const Uint32*) b].title);
+}
+
+// A function to sort postings by trigram, then by document
+static int compare_postings(const void *a, const void *b)
+{
+    Uint64 posting_a = *(const Uint64*) a;
+    Uint64 posting_b = *(const Uint64*) b;
+    return (posting_a > posting_b) - (posting_a < posting_b);
+}
+
+// A function to build the index from the entries of all menus. The titles of
+// the entries are stored in lowercase and sorted for prefix queries, and every
+// trigram of a title is mapped to the documents that contain it.
+static void build_index()
+{
+    free_index();
+    Uint32 start_ticks = SDL_GetTicks();
+
+    // Collect the entries and their lowercase titles
+    size_t title_bytes = 0;
+    Uint32 num_documents = 0;
+    Menu *menu = config.first_menu;
+    for (size_t i = 0; i < config.num_menus; i++, menu = menu->next) {
+        for (unsigned int j = 0; j < menu->num_entries; j++) {
+            if (!is_searchable(menu->entry_info[j].cmd))
+                continue;
+            title_bytes += strlen(menu->entry_info[j].title) + 1;
+            num_documents++;
+        }
+    }
+    search_index.documents = malloc(num_documents * sizeof(SearchDocument));
+    search_index.titles = malloc(title_bytes + 1);
+    search_index.sorted = malloc(num_documents * sizeof(Uint32));
+    size_t offset = 0;
+    size_t num_postings = 0;
+    menu = config.first_menu;
+    for (size_t i = 0; i < config.num_menus; i++, menu = menu->next) {
+        for (unsigned int j = 0; j < menu->num_entries; j++) {
+            if (!is_searchable(menu->entry_info[j].cmd))
+                continue;
+            char *title = search_index.titles + offset;
+            size_t length = strlen(menu->entry_info[j].title);
+            memcpy(title, menu->entry_info[j].title, length + 1);
+            lowercase(title);
+            search_index.documents[search_index.num_documents] = (SearchDocument) {
+                .menu = menu,
+                .index = j,
+                .title = (Uint32) offset
+            };
+            search_index.sorted[search_index.num_documents] = search_index.num_documents;
+            search_index.num_documents++;
+            offset += length + 1;
+            if (length >= SEARCH_TRIGRAM_LENGTH)
+                num_postings += length - SEARCH_TRIGRAM_LENGTH + 1;
+        }
+    }
+    qsort(search_index.sorted, search_index.num_documents, sizeof(Uint32), compare_titles);
+
+    // Sort the trigrams of all titles, so the documents of a trigram are adjacent
+    Uint64 *postings = malloc(num_postings * sizeof(Uint64));
+    num_postings = 0;
+    for (Uint32 i = 0; i < search_index.num_documents; i++) {
+        const char *title = search_index.titles + search_index.documents[i].title;
+        for (const char *p = title; p[0] != '\0' && p[1] != '\0' && p[2] != '\0'; p++)
+            postings[num_postings++] = ((Uint64) get_trigram_key(p) << 32) | i;
+    }
+    qsort(postings, num_postings, sizeof(Uint64), compare_postings);
+
+    // Store the distinct documents of each trigram, the table is at most half full
+    Uint32 num_trigrams = 0;
+    for (size_t i = 0; i < num_postings; i++) {
+        if (i == 0 || postings[i] >> 32 != postings[i - 1] >> 32)
+            num_trigrams++;
+    }
+    Uint32 table_size = MIN_TRIGRAM_TABLE_SIZE;
+    while (table_size < 2 * num_trigrams)
+        table_size *= 2;
+    search_index.trigrams = calloc(table_size, sizeof(SearchTrigram));
+    search_index.trigram_mask = table_size - 1;
+    search_index.postings = malloc(num_postings * sizeof(Uint32));
+    Uint32 num_stored = 0;
+    SearchTrigram *trigram = NULL;
+    for (size_t i = 0; i < num_postings; i++) {
+        Uint32 key = (Uint32) (postings[i] >> 32);
+        if (i > 0 && postings[i] == postings[i - 1])
+            continue;
+        if (trigram == NULL || trigram->key != key) {
+            Uint32 slot = hash_trigram(key) & search_index.trigram_mask;
+            while (search_index.trigrams[slot].key != 0)
+                slot = (slot + 1) & search_index.trigram_mask;
+            trigram = search_index.trigrams + slot;
+            *trigram = (SearchTrigram) {
+                .key = key,
+                .first = num_stored,
+                .count = 0
+            };
+        }
+        search_index.postings[num_stored++] = (Uint32) postings[i];
+        trigram->count++;
+    }
+    free(postings);
+
+    search_index.version = get_directory_menus_version();
+    search_index.rebuilds = get_directory_menus_rebuilds();
+    search_index.built = true;
+    log_debug("Indexed %u entries with %u trigrams for search in %u ms",
+        search_index.num_documents,
+        num_trigrams,
+        SDL_GetTicks() - start_ticks
+    );
+}
+
+// A function to free the search index
+static void free_index()
+{
+    free(search_index.documents);
+    free(search_index.titles);
+    free(search_index.sorted);
+    free(search_index.postings);
+    free(search_index.trigrams);
+    search_index = (SearchIndex) { NULL };
+}
+
+// A function to find the entries of all menus whose title contains a query,
+// titles that start with the query come first. The results are copied into a
+// new menu, so they stay valid if a directory menu changes while they are shown.
+Menu *search_entries(const char *query)
+{
+    // Files found by running scans are only indexed once the scans complete,
+    // so the index isn't rebuilt for every key while files stream in. Until
+    // then the index stays valid because the scans only append entries.
+    if (!search_index.built ||
+    search_index.rebuilds != get_directory_menus_rebuilds() ||
+    (search_index.version != get_directory_menus_version() && !directory_menus_scanning()))
+        build_index();
+
+    retire_results();
+    results = allocate_menu(SEARCH_MENU_NAME);
+    char *buffer = strdup(query);
+    lowercase(buffer);
+    size_t length = strlen(buffer);
+    if (length >= SEARCH_TRIGRAM_LENGTH)
+        search_trigrams(results, buffer, length);
+    else if (length)
+        search_prefix(results, buffer, length);
+    free(buffer);
+    return results;
+}
+
+// A function to find the titles that start with a query too short to have
+// trigrams, by binary search of the sorted titles
+static void search_prefix(Menu *results, const char *query, size_t length)
+{
+    Uint32 low = 0;
+    Uint32 high = search_index.num_documents;
+    while (low < high) {
+        Uint32 middle = low + (high - low) / 2;
+        const char *title = search_index.titles + search_index.documents[search_index.sorted[middle]].title;
+        if (strncmp(title, query, length) < 0)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    for (Uint32 i = low; i < search_index.num_documents && results->num_entries < SEARCH_MAX_RESULTS; i++) {
+        const char *title = search_index.titles + search_index.documents[search_index.sorted[i]].title;
+        if (strncmp(title, query, length))
+            break;
+        add_result(results, search_index.sorted[i]);
+    }
+}
+
+// A function to find the titles that contain a query. Only the documents of
+// the least common trigram of the query are candidates, they are verified
+// against the whole query.
+static void search_trigrams(Menu *results, const char *query, size_t length)
+{
+    SearchTrigram *rarest = NULL;
+    for (size_t i = 0; i + SEARCH_TRIGRAM_LENGTH <= length; i++) {
+        SearchTrigram *trigram = find_trigram(get_trigram_key(query + i));
+        if (trigram == NULL)
+            return;
+        if (rarest == NULL || trigram->count < rarest->count)
+            rarest = trigram;
+    }
+
+    // Add the titles that start with the query first, then the others
+    Uint32 *matches = malloc(SEARCH_MAX_RESULTS * sizeof(Uint32));
+    Uint32 num_matches = 0;
+    for (Uint32 i = 0; i < rarest->count && results->num_entries < SEARCH_MAX_RESULTS; i++) {
+        Uint32 document = search_index.postings[rarest->first + i];
+        const char *title = search_index.titles + search_index.documents[document].title;
+        const char *match = strstr(title, query);
+        if (match == title)
+            add_result(results, document);
+        else if (match != NULL && num_matches < SEARCH_MAX_RESULTS)
+            matches[num_matches++] = document;
+    }
+    for (Uint32 i = 0; i < num_matches && results->num_entries < SEARCH_MAX_RESULTS; i++)
+        add_result(results, matches[i]);
+    free(matches);
+}
+
+// A function to add a copy of an indexed entry to the results
+static void add_result(Menu *results, Uint32 document)
+{
+    SearchDocument *doc = search_index.documents + document;
+    copy_entry(results, doc->menu->entry_info + doc->index);
+}
+
+// A function to retire the current results menu, it is freed
+// once none of its icons or titles are being loaded
+static void retire_results()
+{
+    if (results == NULL)
+        return;
+    if (num_retired == max_retired) {
+        max_retired = max_retired ? 2 * max_retired : MIN_RETIRED_MENUS;
+        retired = realloc(retired, (size_t) max_retired * sizeof(Menu*));
+    }
+    retired[num_retired++] = results;
+    results = NULL;
+}
+
+// A function to stop showing search results
+void clear_search()
+{
+    retire_results();
+}
+
+// A function to free the retired results menus that are no longer loading
+void update_search()
+{
+    int i = 0;
+    while (i < num_retired) {
+        if (menu_loading(retired[i]))
+            i++;
+        else {
+            free_menu(retired[i]);
+            retired[i] = retired[--num_retired];
+        }
+    }
+}
@@ -0,0 +1,41 @@
+#define SEARCH_MENU_NAME "Search"
+#define SEARCH_MAX_RESULTS 1000
+#define SEARCH_TRIGRAM_LENGTH 3
+#define MIN_TRIGRAM_TABLE_SIZE 64
+#define MIN_RETIRED_MENUS 4
+
+// Entry of a menu in the search index
+typedef struct {
+    Menu *menu;
+    unsigned int index;
+    Uint32 title; // Offset of the lowercase title in the title buffer
+} SearchDocument;
+
+// Slot of the trigram table, the documents that contain the
+// trigram are stored consecutively in the postings array
+typedef struct {
+    Uint32 key; // Bytes of the trigram, 0 if the slot is empty
+    Uint32 first;
+    Uint32 count;
+} SearchTrigram;
+
+// Index of the titles of all menu entries, sorted titles answer
+// short queries by prefix and trigrams answer longer ones
+typedef struct {
+    SearchDocument *documents;
+    Uint32 num_documents;
+    char *titles;
+    Uint32 *sorted; // Documents sorted by title
+    Uint32 *postings;
+    SearchTrigram *trigrams;
+    Uint32 trigram_mask;
+    Uint32 version; // Directory menus version the index was built from
+    Uint32 rebuilds; // Directory menus rebuilds the index was built from
+    bool built;
+} SearchIndex;
+
+void init_search(void);
+void quit_search(void);
+Menu *search_entries(const char *query);
+void clear_search(void);
+void update_search(void);
@@ -0,0 +1,540 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include "launcher.h"
+#include <launcher_config.h>
+#include "slideshow.h"
+#include "image.h"
+#include "cache.h"
+#include "util.h"
+#include "debug.h"
+#include "platform/platform.h"
+#include "platform/slideshow.h"
+
+static int monitor_slideshow_directory_async(void *data);
+static int probe_slideshow_images_async(void *data);
+static bool is_usable_image(ImageInfo *info);
+static void release_image(Slideshow *slideshow, int index);
+static void compact_images(Slideshow *slideshow);
+static void get_index_path(char *buffer, size_t bytes);
+static void load_index(void);
+static void free_index(void);
+static SlideshowImage *find_indexed_image(const char *path);
+static void save_index(Slideshow *slideshow);
+
+extern Config config;
+
+// Image information stored from a previous run, only kept during the initial scan
+static SlideshowImage *index_images = NULL;
+static int num_index_images         = 0;
+static int num_index_matches        = 0;
+static StringTable index_table      = { NULL };
+static bool saving_index            = false;
+
+// A function to start scanning the slideshow directory in a separate thread,
+// waits until enough images are found to start the slideshow
+void init_slideshow_images(Slideshow *slideshow)
+{
+    slideshow->mutex = SDL_CreateMutex();
+    slideshow->scan_cond = SDL_CreateCond();
+    slideshow->probe_cond = SDL_CreateCond();
+    slideshow->scan_complete = false;
+    SDL_AtomicSet(&slideshow->quit, 0);
+    slideshow->random_state = (Uint64) time(NULL) ^ SDL_GetPerformanceCounter();
+    slideshow->order.size = 0;
+
+    // Image headers are read by a small pool of threads while the directory is scanned
+    int num_threads = MIN(SDL_GetCPUCount(), MAX_PROBE_THREADS);
+    for (int i = 0; i < num_threads; i++) {
+        SDL_Thread *thread = SDL_CreateThread(probe_slideshow_images_async, "Slideshow Probe Thread", (void*) slideshow);
+        if (thread == NULL) {
+            log_error("Could not create slideshow probe thread\n%s", SDL_GetError());
+            break;
+        }
+        slideshow->probe_threads[slideshow->num_probe_threads++] = thread;
+    }
+    if (!slideshow->num_probe_threads)
+        return;
+
+    slideshow->scan_thread = SDL_CreateThread(monitor_slideshow_directory_async, "Slideshow Scan Thread", (void*) slideshow);
+    if (slideshow->scan_thread == NULL) {
+        log_error("Could not create slideshow scan thread\n%s", SDL_GetError());
+        return;
+    }
+
+    SDL_LockMutex(slideshow->mutex);
+    while (slideshow->num_available < SLIDESHOW_MIN_IMAGES &&
+    (!slideshow->scan_complete || slideshow->num_pending))
+        SDL_CondWait(slideshow->scan_cond, slideshow->mutex);
+    SDL_UnlockMutex(slideshow->mutex);
+}
+
+// A function to stop monitoring the slideshow directory and free the image list
+void quit_slideshow_images(Slideshow *slideshow)
+{
+    SDL_LockMutex(slideshow->mutex);
+    SDL_AtomicSet(&slideshow->quit, 1);
+    SDL_CondBroadcast(slideshow->probe_cond);
+    SDL_UnlockMutex(slideshow->mutex);
+    SDL_WaitThread(slideshow->scan_thread, NULL);
+    slideshow->scan_thread = NULL;
+    for (int i = 0; i < slideshow->num_probe_threads; i++)
+        SDL_WaitThread(slideshow->probe_threads[i], NULL);
+    slideshow->num_probe_threads = 0;
+
+    // Keep whatever was learned about the images for the next run
+    if (slideshow->index_modified && slideshow->scan_complete)
+        save_index(slideshow);
+    free_index();
+
+    for (int i = 0; i < slideshow->num_images; i++)
+        free(slideshow->images[i].path);
+    free(slideshow->images);
+    free(slideshow->probe_queue);
+    free(slideshow->free_images);
+    free_string_table(&slideshow->paths);
+    slideshow->images = NULL;
+    slideshow->probe_queue = NULL;
+    slideshow->free_images = NULL;
+    slideshow->num_images = 0;
+    slideshow->num_free_images = 0;
+    slideshow->max_free_images = 0;
+    slideshow->num_available = 0;
+    slideshow->num_probes = 0;
+    slideshow->num_pending = 0;
+    SDL_DestroyCond(slideshow->probe_cond);
+    SDL_DestroyCond(slideshow->scan_cond);
+    SDL_DestroyMutex(slideshow->mutex);
+}
+
+// A function to scan and watch the slideshow directory in a separate thread
+static int monitor_slideshow_directory_async(void *data)
+{
+    Slideshow *slideshow = (Slideshow*) data;
+    load_index();
+    monitor_slideshow_directory(slideshow, config.slideshow_directory);
+    finish_slideshow_scan(slideshow);
+    return 0;
+}
+
+// A function to signal that the initial scan of the slideshow directory is done
+void finish_slideshow_scan(Slideshow *slideshow)
+{
+    SDL_LockMutex(slideshow->mutex);
+    if (!slideshow->scan_complete) {
+        slideshow->scan_complete = true;
+
+        // Drop records of images that no longer exist from the index
+        if (num_index_matches != num_index_images)
+            slideshow->index_modified = true;
+        free_index();
+        log_debug("Found %i images in slideshow directory %s, %i waiting to be probed",
+            slideshow->num_images,
+            config.slideshow_directory,
+            slideshow->num_pending
+        );
+    }
+    SDL_CondBroadcast(slideshow->scan_cond);
+    SDL_CondBroadcast(slideshow->probe_cond);
+    SDL_UnlockMutex(slideshow->mutex);
+}
+
+// A function to determine if the slideshow directory monitor should exit
+bool slideshow_quit_requested(Slideshow *slideshow)
+{
+    return SDL_AtomicGet(&slideshow->quit) ? true : false;
+}
+
+// A function to determine if a file has an image extension
+bool is_image_file(const char *file)
+{
+    size_t len_file = strlen(file);
+    size_t len_extension;
+    for (size_t i = 0; i < NUM_IMAGE_EXTENSIONS; i++) {
+        len_extension = strlen(extensions[i]);
+        if (len_file > len_extension &&
+        !SDL_strcasecmp(file + len_file - len_extension, extensions[i]))
+            return true;
+    }
+    return false;
+}
+
+// A function to determine if probed image dimensions are suitable for a background
+static bool is_usable_image(ImageInfo *info)
+{
+    return info->width >= MIN_SLIDESHOW_IMAGE_DIMENSION &&
+           info->height >= MIN_SLIDESHOW_IMAGE_DIMENSION &&
+           info->width <= MAX_SLIDESHOW_IMAGE_DIMENSION &&
+           info->height <= MAX_SLIDESHOW_IMAGE_DIMENSION;
+}
+
+// A function to add an image to the slideshow, the image becomes
+// available once its header was probed or found in the index.
+// An image that is already in the slideshow is probed again if
+// the file was modified.
+void add_slideshow_image(Slideshow *slideshow, const char *path)
+{
+    FileInfo file;
+    if (!get_file_info(path, &file))
+        return;
+
+    SDL_LockMutex(slideshow->mutex);
+    int index = find_string_index(&slideshow->paths, path);
+    if (index != -1) {
+        ImageInfo *info = &slideshow->images[index].info;
+        if (info->mtime == file.mtime && info->size == file.size) {
+            SDL_UnlockMutex(slideshow->mutex);
+            return;
+        }
+        release_image(slideshow, index);
+    }
+
+    // Reuse the slot of a removed image, new slots join
+    // the shuffle at the start of the next cycle
+    if (slideshow->num_free_images)
+        index = slideshow->free_images[--slideshow->num_free_images];
+    else {
+        if (slideshow->num_images == slideshow->max_images) {
+            slideshow->max_images = slideshow->max_images ? 2 * slideshow->max_images : 64;
+            slideshow->images = realloc(slideshow->images, (size_t) slideshow->max_images * sizeof(SlideshowImage));
+        }
+        index = slideshow->num_images++;
+    }
+    SlideshowImage *image = slideshow->images + index;
+    image->path = strdup(path);
+    insert_string_index(&slideshow->paths, image->path, index);
+    SlideshowImage *indexed = find_indexed_image(path);
+    if (indexed != NULL && indexed->info.mtime == file.mtime && indexed->info.size == file.size) {
+        image->info = indexed->info;
+        num_index_matches++;
+    }
+    else {
+        image->info = (ImageInfo) {
+            .mtime = file.mtime,
+            .size = file.size,
+            .status = IMAGE_STATUS_PENDING
+        };
+        slideshow->index_modified = true;
+    }
+
+    if (image->info.status == IMAGE_STATUS_VALID) {
+        slideshow->num_available++;
+        if (slideshow->num_available == SLIDESHOW_MIN_IMAGES)
+            SDL_CondBroadcast(slideshow->scan_cond);
+    }
+    else if (image->info.status == IMAGE_STATUS_PENDING) {
+        if (slideshow->num_probes == slideshow->max_probes) {
+            slideshow->max_probes = slideshow->max_probes ? 2 * slideshow->max_probes : 64;
+            slideshow->probe_queue = realloc(slideshow->probe_queue, (size_t) slideshow->max_probes * sizeof(int));
+        }
+        slideshow->probe_queue[slideshow->num_probes++] = index;
+        slideshow->num_pending++;
+        SDL_CondSignal(slideshow->probe_cond);
+    }
+    SDL_UnlockMutex(slideshow->mutex);
+}
+
+// A function to remove an image, or every image inside a directory, from the slideshow
+void remove_slideshow_images(Slideshow *slideshow, const char *path)
+{
+    SDL_LockMutex(slideshow->mutex);
+    int index = find_string_index(&slideshow->paths, path);
+    if (index != -1)
+        release_image(slideshow, index);
+    else {
+        size_t length = strlen(path);
+        for (int i = 0; i < slideshow->num_images; i++) {
+            SlideshowImage *image = slideshow->images + i;
+            if (image->path != NULL && !strncmp(image->path, path, length) &&
+            image->path[length] == *PATH_SEPARATOR)
+                release_image(slideshow, i);
+        }
+    }
+    SDL_UnlockMutex(slideshow->mutex);
+}
+
+// A function to free the slot of an image for reuse, the lock must be held
+static void release_image(Slideshow *slideshow, int index)
+{
+    SlideshowImage *image = slideshow->images + index;
+    log_debug("Removed slideshow image %s", image->path);
+    remove_string_index(&slideshow->paths, image->path);
+    free(image->path);
+    image->path = NULL;
+    if (image->info.status == IMAGE_STATUS_VALID)
+        slideshow->num_available--;
+    else if (image->info.status == IMAGE_STATUS_PENDING)
+        slideshow->num_pending--;
+    slideshow->index_modified = true;
+    if (slideshow->num_free_images == slideshow->max_free_images) {
+        slideshow->max_free_images = slideshow->max_free_images ? 2 * slideshow->max_free_images : 64;
+        slideshow->free_images = realloc(slideshow->free_images, (size_t) slideshow->max_free_images * sizeof(int));
+    }
+    slideshow->free_images[slideshow->num_free_images++] = index;
+}
+
+// A function to move the images over the slots of removed images, the lock
+// must be held and no probes may be queued. Probes that are running find
+// their image by its path.
+static void compact_images(Slideshow *slideshow)
+{
+    int num_images = 0;
+    free_string_table(&slideshow->paths);
+    for (int i = 0; i < slideshow->num_images; i++) {
+        if (slideshow->images[i].path == NULL)
+            continue;
+        slideshow->images[num_images] = slideshow->images[i];
+        insert_string_index(&slideshow->paths, slideshow->images[num_images].path, num_images);
+        num_images++;
+    }
+    slideshow->num_images = num_images;
+    slideshow->num_free_images = 0;
+}
+
+// A function to exclude an image that could not be decoded from the slideshow
+void invalidate_slideshow_image(Slideshow *slideshow, const char *path)
+{
+    SDL_LockMutex(slideshow->mutex);
+    int index = find_string_index(&slideshow->paths, path);
+    if (index != -1 && slideshow->images[index].info.status == IMAGE_STATUS_VALID) {
+        slideshow->images[index].info.status = IMAGE_STATUS_INVALID;
+        slideshow->num_available--;
+        slideshow->index_modified = true;
+    }
+    SDL_UnlockMutex(slideshow->mutex);
+}
+
+// A function to read the headers of newly found images in a separate thread
+static int probe_slideshow_images_async(void *data)
+{
+    Slideshow *slideshow = (Slideshow*) data;
+    ImageInfo info;
+    SDL_LockMutex(slideshow->mutex);
+    while (!slideshow_quit_requested(slideshow)) {
+        if (!slideshow->num_probes) {
+            // Store the index once every image of the initial scan is known
+            if (slideshow->scan_complete && !slideshow->num_pending && slideshow->index_modified && !saving_index) {
+                saving_index = true;
+                SDL_UnlockMutex(slideshow->mutex);
+                save_index(slideshow);
+                SDL_LockMutex(slideshow->mutex);
+            }
+            else
+                SDL_CondWait(slideshow->probe_cond, slideshow->mutex);
+            continue;
+        }
+
+        // Read the header without holding the lock
+        int index = slideshow->probe_queue[--slideshow->num_probes];
+        if (slideshow->images[index].path == NULL)
+            continue;
+        char *path = strdup(slideshow->images[index].path);
+        SDL_UnlockMutex(slideshow->mutex);
+        bool valid = read_image_info(path, &info) && is_usable_image(&info);
+        if (!valid)
+            log_debug("Skipping slideshow image %s", path);
+        SDL_LockMutex(slideshow->mutex);
+
+        // The image may have been removed or moved to another slot in the meantime
+        index = find_string_index(&slideshow->paths, path);
+        free(path);
+        if (index == -1)
+            continue;
+        SlideshowImage *image = slideshow->images + index;
+        if (image->info.status != IMAGE_STATUS_PENDING)
+            continue;
+        image->info.width = info.width;
+        image->info.height = info.height;
+        image->info.format = info.format;
+        image->info.orientation = info.orientation;
+        image->info.status = valid ? IMAGE_STATUS_VALID : IMAGE_STATUS_INVALID;
+        slideshow->num_pending--;
+        if (valid)
+            slideshow->num_available++;
+        if (slideshow->num_available == SLIDESHOW_MIN_IMAGES || !slideshow->num_pending)
+            SDL_CondBroadcast(slideshow->scan_cond);
+    }
+    SDL_UnlockMutex(slideshow->mutex);
+    return 0;
+}
+
+// A function to get the path of the slideshow index file
+static void get_index_path(char *buffer, size_t bytes)
+{
+    char directory[MAX_PATH_CHARS + 1];
+    get_cache_directory(directory, sizeof(directory));
+    join_paths(buffer, bytes, 2, directory, INDEX_FILE);
+}
+
+// A function to load the image information stored by a previous run
+// into a hash table
+static void load_index()
+{
+    char path[MAX_PATH_CHARS + 1];
+    get_index_path(path, sizeof(path));
+    size_t size = 0;
+    Uint8 *data = map_file(path, &size);
+    if (data == NULL)
+        return;
+
+    IndexHeader *header = (IndexHeader*) data;
+    if (size < sizeof(IndexHeader) ||
+    header->magic != INDEX_MAGIC ||
+    header->version != INDEX_VERSION ||
+    header->num_records > (size - sizeof(IndexHeader)) / sizeof(IndexRecord)) {
+        unmap_file(data, size);
+        return;
+    }
+
+    // Read records
+    index_images = malloc((size_t) header->num_records * sizeof(SlideshowImage));
+    size_t offset = sizeof(IndexHeader);
+    for (Uint32 i = 0; i < header->num_records; i++) {
+        if (offset + sizeof(IndexRecord) > size)
+            break;
+        IndexRecord record;
+        memcpy(&record, data + offset, sizeof(IndexRecord));
+        offset += sizeof(IndexRecord);
+        if (offset + record.path_length > size)
+            break;
+        SlideshowImage *image = index_images + num_index_images;
+        image->path = malloc(record.path_length + 1);
+        memcpy(image->path, data + offset, record.path_length);
+        image->path[record.path_length] = '\0';
+        image->info = (ImageInfo) {
+            .mtime = record.mtime,
+            .size = record.size,
+            .width = record.width,
+            .height = record.height,
+            .format = record.format,
+            .orientation = record.orientation,
+            .status = record.status
+        };
+        offset += record.path_length;
+        insert_string_index(&index_table, image->path, num_index_images++);
+    }
+    unmap_file(data, size);
+    log_debug("Loaded %i records from slideshow index %s", num_index_images, path);
+}
+
+// A function to free the image information of the previous run
+static void free_index()
+{
+    for (int i = 0; i < num_index_images; i++)
+        free(index_images[i].path);
+    free(index_images);
+    free_string_table(&index_table);
+    index_images = NULL;
+    num_index_images = 0;
+    num_index_matches = 0;
+}
+
+// A function to find the stored information of an image, records
+// of images that were never probed are ignored
+static SlideshowImage *find_indexed_image(const char *path)
+{
+    int index = find_string_index(&index_table, path);
+    if (index == -1 || index_images[index].info.status == IMAGE_STATUS_PENDING)
+        return NULL;
+    return index_images + index;
+}
+
+// A function to store the information of every slideshow image
+// in the index, so their headers do not need to be read next time
+static void save_index(Slideshow *slideshow)
+{
+    // Serialize the records while holding the lock
+    SDL_LockMutex(slideshow->mutex);
+    saving_index = true;
+    slideshow->index_modified = false;
+    size_t size = sizeof(IndexHeader);
+    for (int i = 0; i < slideshow->num_images; i++) {
+        if (slideshow->images[i].path != NULL && slideshow->images[i].info.status != IMAGE_STATUS_PENDING)
+            size += sizeof(IndexRecord) + strlen(slideshow->images[i].path);
+    }
+    Uint8 *buffer = malloc(size);
+    IndexHeader header = {
+        .magic = INDEX_MAGIC,
+        .version = INDEX_VERSION,
+        .num_records = 0
+    };
+    size_t offset = sizeof(IndexHeader);
+    for (int i = 0; i < slideshow->num_images; i++) {
+        SlideshowImage *image = slideshow->images + i;
+        if (image->path == NULL || image->info.status == IMAGE_STATUS_PENDING)
+            continue;
+        IndexRecord record = {
+            .mtime = image->info.mtime,
+            .size = image->info.size,
+            .width = image->info.width,
+            .height = image->info.height,
+            .path_length = (Uint32) strlen(image->path),
+            .format = image->info.format,
+            .orientation = image->info.orientation,
+            .status = image->info.status,
+            .reserved = 0
+        };
+        memcpy(buffer + offset, &record, sizeof(IndexRecord));
+        offset += sizeof(IndexRecord);
+        memcpy(buffer + offset, image->path, record.path_length);
+        offset += record.path_length;
+        header.num_records++;
+    }
+    memcpy(buffer, &header, sizeof(IndexHeader));
+    SDL_UnlockMutex(slideshow->mutex);
+
+    // Write to a temporary file first so a partial index is never loaded
+    char path[MAX_PATH_CHARS + 1];
+    char tmp_path[MAX_PATH_CHARS + 1];
+    char directory[MAX_PATH_CHARS + 1];
+    get_index_path(path, sizeof(path));
+    snprintf(tmp_path, sizeof(tmp_path), "%s%s", path, INDEX_TMP_EXTENSION);
+    make_directory(get_cache_directory(directory, sizeof(directory)));
+    FILE *file = fopen(tmp_path, "wb");
+    bool error = file == NULL || fwrite(buffer, 1, size, file) != size;
+    if (file != NULL)
+        fclose(file);
+    if (error || !replace_file(tmp_path, path)) {
+        log_error("Could not write slideshow index %s", path);
+        remove(tmp_path);
+    }
+    else
+        log_debug("Saved %i records to slideshow index %s", (int) header.num_records, path);
+    free(buffer);
+
+    SDL_LockMutex(slideshow->mutex);
+    saving_index = false;
+    SDL_UnlockMutex(slideshow->mutex);
+}
+
+// A function to get a copy of the path of the next slideshow image and its
+// EXIF orientation, images are not repeated until every image was shown once
+char *get_next_slideshow_image(Slideshow *slideshow, Uint8 *orientation)
+{
+    char *path = NULL;
+    SDL_LockMutex(slideshow->mutex);
+    for (int n = 0; n < slideshow->num_images && path == NULL; n++) {
+        slideshow->i++;
+
+        // Start a new cycle with a new shuffle including any images added,
+        // the slots of removed images are dropped first
+        if (slideshow->i >= (int) slideshow->order.size) {
+            if (slideshow->num_free_images && !slideshow->num_probes)
+                compact_images(slideshow);
+            init_permutation(&slideshow->order, (Uint32) slideshow->num_images, &slideshow->random_state);
+            slideshow->i = 0;
+        }
+        SlideshowImage *image = slideshow->images + permute_index(&slideshow->order, (Uint32) slideshow->i);
+        if (image->path != NULL && image->info.status == IMAGE_STATUS_VALID) {
+            path = strdup(image->path);
+            if (orientation != NULL)
+                *orientation = image->info.orientation;
+        }
+    }
+    SDL_UnlockMutex(slideshow->mutex);
+    return path;
+}
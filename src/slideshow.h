@@ -0,0 +1,37 @@
+#define SLIDESHOW_MIN_IMAGES 2
+#define SLIDESHOW_WATCH_PERIOD 250
+#define INDEX_MAGIC 0x58444953 // "SIDX"
+#define INDEX_VERSION 2
+#define INDEX_FILE "slideshow.idx"
+#define INDEX_TMP_EXTENSION ".tmp"
+
+// Header of the slideshow index file, followed by the records
+typedef struct {
+    Uint32 magic;
+    Uint32 version;
+    Uint32 num_records;
+} IndexHeader;
+
+// Record of a slideshow index file, followed by the image path.
+// The fields are ordered so the record has no padding bytes.
+typedef struct {
+    Sint64 mtime;
+    Sint64 size;
+    Sint32 width;
+    Sint32 height;
+    Uint32 path_length;
+    Uint8  format;
+    Uint8  orientation;
+    Uint8  status;
+    Uint8  reserved; // Always 0
+} IndexRecord;
+
+void init_slideshow_images(Slideshow *slideshow);
+void quit_slideshow_images(Slideshow *slideshow);
+void add_slideshow_image(Slideshow *slideshow, const char *path);
+void remove_slideshow_images(Slideshow *slideshow, const char *path);
+void invalidate_slideshow_image(Slideshow *slideshow, const char *path);
+void finish_slideshow_scan(Slideshow *slideshow);
+bool slideshow_quit_requested(Slideshow *slideshow);
+bool is_image_file(const char *file);
+char *get_next_slideshow_image(Slideshow *slideshow, Uint8 *orientation);
@@ -0,0 +1,265 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <SDL.h>
+#include "launcher.h"
+#include <launcher_config.h>
+#include "sources.h"
+#include "worker.h"
+#include "util.h"
+#include "debug.h"
+#include "platform/platform.h"
+
+static Source *find_source(const char *name, size_t length);
+static Source *parse_reference(const char *text, size_t *length);
+static bool read_file_line(const char *path, char *buffer, size_t bytes);
+static void trim_value(char *value);
+static void refresh_source_async(void *data);
+static void complete_source(void *data, bool cancelled);
+
+extern Ticks ticks;
+
+static Source *sources = NULL;
+static Source *last_source = NULL;
+static Uint32 version = 0; // Incremented whenever the value of a source changes
+
+// A function to add a data source from the config file, the value
+// is the refresh interval in seconds followed by the command
+void add_source(const char *name, const char *value)
+{
+    char *string = strdup(value);
+    char *interval = strtok(string, ";");
+    char *command = strtok(NULL, "");
+    int seconds = interval != NULL ? atoi(interval) : 0;
+    if (command == NULL || seconds < MIN_SOURCE_INTERVAL || seconds > MAX_SOURCE_INTERVAL) {
+        log_error("Invalid data source '%s', the value must be an interval of %i to %i seconds and a command",
+            name,
+            MIN_SOURCE_INTERVAL,
+            MAX_SOURCE_INTERVAL
+        );
+        free(string);
+        return;
+    }
+    if (find_source(name, strlen(name)) != NULL) {
+        log_error("Data source '%s' is defined more than once", name);
+        free(string);
+        return;
+    }
+
+    Source *source = malloc(sizeof(Source));
+    *source = (Source) {
+        .name = strdup(name),
+        .command = NULL,
+        .path = NULL,
+        .interval = (Uint32) seconds * 1000,
+        .last_refresh = 0,
+        .refreshed = false,
+        .changed = 0,
+        .job = NULL,
+        .next = NULL
+    };
+    source->value[0] = '\0';
+    size_t length = strlen(SOURCE_READ);
+    if (!strncmp(command, SOURCE_READ, length) && command[length] == ' ') {
+        source->path = strdup(command + length + 1);
+        clean_path(source->path);
+    }
+    else
+        source->command = strdup(command);
+    free(string);
+
+    if (sources == NULL)
+        sources = source;
+    else
+        last_source->next = source;
+    last_source = source;
+}
+
+// A function to free all data sources, the workers must be stopped
+void quit_sources()
+{
+    Source *next;
+    for (Source *source = sources; source != NULL; source = next) {
+        next = source->next;
+        free(source->name);
+        free(source->command);
+        free(source->path);
+        free(source);
+    }
+    sources = NULL;
+    last_source = NULL;
+}
+
+// A function to look up a data source by name
+static Source *find_source(const char *name, size_t length)
+{
+    for (Source *source = sources; source != NULL; source = source->next) {
+        if (strlen(source->name) == length && !strncmp(source->name, name, length))
+            return source;
+    }
+    return NULL;
+}
+
+// A function to get the data source a text refers to with its name in braces,
+// NULL if the text doesn't start with the name of a source in braces
+static Source *parse_reference(const char *text, size_t *length)
+{
+    if (*text != SOURCE_REFERENCE_START)
+        return NULL;
+    const char *end = strchr(text + 1, SOURCE_REFERENCE_END);
+    if (end == NULL)
+        return NULL;
+    Source *source = find_source(text + 1, (size_t) (end - text - 1));
+    if (source != NULL)
+        *length = (size_t) (end - text + 1);
+    return source;
+}
+
+// A function to submit a refresh of every data source whose interval has
+// passed. A source is refreshed by one worker at a time, so a slow command
+// delays only its own value.
+void update_sources()
+{
+    for (Source *source = sources; source != NULL; source = source->next) {
+        if (source->job != NULL || (source->refreshed && ticks.main - source->last_refresh < source->interval))
+            continue;
+        copy_string(source->result, source->value, sizeof(source->result));
+        source->refreshed = true;
+        source->last_refresh = ticks.main;
+        source->job = submit_job(PRIORITY_BACKGROUND, refresh_source_async, complete_source, (void*) source);
+    }
+}
+
+// A function to read the first line of a file
+static bool read_file_line(const char *path, char *buffer, size_t bytes)
+{
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+        return false;
+    if (fgets(buffer, (int) bytes, file) == NULL)
+        buffer[0] = '\0';
+    fclose(file);
+    return true;
+}
+
+// A function to remove the line break and trailing whitespace of a value
+static void trim_value(char *value)
+{
+    size_t length = strlen(value);
+    while (length && (value[length - 1] == '\n' || value[length - 1] == '\r' ||
+    value[length - 1] == ' ' || value[length - 1] == '\t'))
+        length--;
+    value[length] = '\0';
+}
+
+// A function to read the value of a data source in a worker thread,
+// the previous value is kept if the command or file can't be read
+static void refresh_source_async(void *data)
+{
+    Source *source = (Source*) data;
+    char buffer[MAX_SOURCE_VALUE_BYTES];
+    bool success;
+    if (source->command != NULL)
+        success = read_command_output(source->command, buffer, sizeof(buffer));
+    else
+        success = read_file_line(source->path, buffer, sizeof(buffer));
+    if (!success)
+        return;
+    trim_value(buffer);
+    copy_string(source->result, buffer, sizeof(source->result));
+}
+
+// A function to store the value of a data source after it was refreshed
+static void complete_source(void *data, bool cancelled)
+{
+    Source *source = (Source*) data;
+    source->job = NULL;
+    source->last_refresh = ticks.main;
+    if (cancelled || !strcmp(source->value, source->result))
+        return;
+    copy_string(source->value, source->result, sizeof(source->value));
+    source->changed = ++version;
+}
+
+// A function to get a number that changes whenever the value of a data source changes
+Uint32 get_sources_version()
+{
+    return version;
+}
+
+// A function to get the number of milliseconds until the next data source
+// is due for a refresh, or -1 if no source is waiting for its interval
+int get_sources_timeout()
+{
+    int timeout = -1;
+    Uint32 current_ticks = SDL_GetTicks();
+    for (Source *source = sources; source != NULL; source = source->next) {
+        if (source->job != NULL)
+            continue;
+        Uint32 elapsed = current_ticks - source->last_refresh;
+        int remaining = !source->refreshed || elapsed >= source->interval ? 0 : (int) (source->interval - elapsed);
+        if (timeout < 0 || remaining < timeout)
+            timeout = remaining;
+    }
+    return timeout;
+}
+
+// A function to determine if a text refers to any data source
+bool has_sources(const char *text)
+{
+    size_t length;
+    for (const char *p = strchr(text, SOURCE_REFERENCE_START); p != NULL; p = strchr(p + 1, SOURCE_REFERENCE_START)) {
+        if (parse_reference(p, &length) != NULL)
+            return true;
+    }
+    return false;
+}
+
+// A function to determine if a text refers to a data source whose
+// value changed after a version of the sources
+bool sources_changed(const char *text, Uint32 since)
+{
+    size_t length;
+    for (const char *p = strchr(text, SOURCE_REFERENCE_START); p != NULL; p = strchr(p + 1, SOURCE_REFERENCE_START)) {
+        Source *source = parse_reference(p, &length);
+        if (source != NULL && source->changed > since)
+            return true;
+    }
+    return false;
+}
+
+// A function to replace the names of data sources in braces with their
+// latest values, braces around anything else are kept
+char *expand_sources(const char *text)
+{
+    size_t bytes = 1;
+    size_t length;
+    for (const char *p = text; *p != '\0';) {
+        Source *source = parse_reference(p, &length);
+        if (source != NULL) {
+            bytes += strlen(source->value);
+            p += length;
+        }
+        else {
+            bytes++;
+            p++;
+        }
+    }
+
+    char *expanded = malloc(bytes);
+    char *q = expanded;
+    for (const char *p = text; *p != '\0';) {
+        Source *source = parse_reference(p, &length);
+        if (source != NULL) {
+            size_t value_length = strlen(source->value);
+            memcpy(q, source->value, value_length);
+            q += value_length;
+            p += length;
+        }
+        else
+            *q++ = *p++;
+    }
+    *q = '\0';
+    return expanded;
+}
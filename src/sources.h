@@ -0,0 +1,31 @@
+#define MAX_SOURCE_VALUE_BYTES 256
+#define MIN_SOURCE_INTERVAL 1
+#define MAX_SOURCE_INTERVAL 86400
+#define SOURCE_READ ":read"
+#define SOURCE_REFERENCE_START '{'
+#define SOURCE_REFERENCE_END '}'
+
+// Text that is refreshed in a worker thread at an interval, the output
+// of a shell command or the first line of a file such as in /proc or /sys
+typedef struct source {
+    char *name;
+    char *command; // Shell command, NULL if a file is read
+    char *path; // File to read, NULL if a command is run
+    Uint32 interval; // Milliseconds between refreshes
+    Uint32 last_refresh;
+    bool refreshed;
+    char value[MAX_SOURCE_VALUE_BYTES]; // Latest value, only used by the main thread
+    char result[MAX_SOURCE_VALUE_BYTES]; // Value read by the worker thread
+    Uint32 changed; // Sources version of the last change of the value
+    struct job *job;
+    struct source *next;
+} Source;
+
+void add_source(const char *name, const char *value);
+void quit_sources(void);
+void update_sources(void);
+Uint32 get_sources_version(void);
+int get_sources_timeout(void);
+bool has_sources(const char *text);
+bool sources_changed(const char *text, Uint32 version);
+char *expand_sources(const char *text);
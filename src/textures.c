@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include "launcher.h"
+#include <launcher_config.h>
+#include "textures.h"
+#include "atlas.h"
+#include "image.h"
+#include "util.h"
+#include "debug.h"
+
+extern Config config;
+
+static SDL_mutex *texture_mutex               = NULL;
+static Sint64 usage[NUM_TEXTURE_CATEGORIES]   = {0};
+static int counts[NUM_TEXTURE_CATEGORIES]     = {0};
+
+// Names of the texture categories for the debug output
+static const char *category_names[] = {
+    "Background",
+    "Slideshow",
+    "Video",
+    "Clock",
+    "Atlas",
+    "Menu",
+    "Interface"
+};
+
+// A function to initialize the texture accounting, textures
+// may be created by the video thread
+void init_textures()
+{
+    texture_mutex = SDL_CreateMutex();
+}
+
+// A function to close the texture accounting
+void quit_textures()
+{
+    SDL_DestroyMutex(texture_mutex);
+    texture_mutex = NULL;
+}
+
+// A function to account for the video memory of a new texture
+SDL_Texture *track_texture(SDL_Texture *texture, TextureCategory category)
+{
+    if (texture == NULL)
+        return NULL;
+    TextureRecord *record = malloc(sizeof(TextureRecord));
+    *record = (TextureRecord) {
+        .bytes = get_texture_bytes(texture),
+        .category = category
+    };
+    SDL_SetTextureUserData(texture, record);
+    SDL_LockMutex(texture_mutex);
+    usage[category] += record->bytes;
+    counts[category]++;
+    SDL_UnlockMutex(texture_mutex);
+    return texture;
+}
+
+// A function to destroy a texture and remove it from the accounting
+void destroy_texture(SDL_Texture *texture)
+{
+    if (texture == NULL)
+        return;
+    TextureRecord *record = (TextureRecord*) SDL_GetTextureUserData(texture);
+    if (record != NULL) {
+        SDL_LockMutex(texture_mutex);
+        usage[record->category] -= record->bytes;
+        counts[record->category]--;
+        SDL_UnlockMutex(texture_mutex);
+        free(record);
+    }
+    SDL_DestroyTexture(texture);
+}
+
+// A function to get the video memory used by all tracked textures
+Sint64 get_texture_usage()
+{
+    Sint64 bytes = 0;
+    SDL_LockMutex(texture_mutex);
+    for (int i = 0; i < NUM_TEXTURE_CATEGORIES; i++)
+        bytes += usage[i];
+    SDL_UnlockMutex(texture_mutex);
+    return bytes;
+}
+
+// A function to get the video memory used by the icons and titles of the
+// menus, which counts the atlas regions in use rather than whole pages
+Sint64 get_menu_texture_usage()
+{
+    SDL_LockMutex(texture_mutex);
+    Sint64 bytes = usage[TEXTURE_MENU];
+    SDL_UnlockMutex(texture_mutex);
+    return bytes + get_atlas_usage();
+}
+
+// A function to determine if the icons and titles of the menus use more video
+// memory than the budget. The other textures are not counted, since unloading
+// menus doesn't free them.
+bool texture_budget_exceeded()
+{
+    return config.texture_budget && get_menu_texture_usage() > (Sint64) config.texture_budget * BYTES_PER_MEGABYTE;
+}
+
+// A function to output the video memory used by each category of textures
+void log_texture_usage()
+{
+    if (!config.debug)
+        return;
+    SDL_LockMutex(texture_mutex);
+    for (int i = 0; i < NUM_TEXTURE_CATEGORIES; i++) {
+        if (counts[i])
+            log_debug("%-12s %3i textures %8.1f MB", category_names[i], counts[i], (double) usage[i] / BYTES_PER_MEGABYTE);
+    }
+    SDL_UnlockMutex(texture_mutex);
+    log_debug("Video memory used by menu icons and titles: %.1f MB", (double) get_menu_texture_usage() / BYTES_PER_MEGABYTE);
+    log_debug("Total video memory used by textures: %.1f MB", (double) get_texture_usage() / BYTES_PER_MEGABYTE);
+}
@@ -0,0 +1,26 @@
+// Uses of textures, the video memory of each is accounted separately
+typedef enum {
+    TEXTURE_BACKGROUND,
+    TEXTURE_SLIDESHOW,
+    TEXTURE_VIDEO,
+    TEXTURE_CLOCK,
+    TEXTURE_ATLAS, // Pages of the texture atlas that hold the icons and titles
+    TEXTURE_MENU, // Icons or titles too large for the atlas
+    TEXTURE_INTERFACE, // Highlight, scroll indicators, screensaver and search prompt
+    NUM_TEXTURE_CATEGORIES
+} TextureCategory;
+
+// Accounting of a texture, stored in its userdata
+typedef struct {
+    Sint64 bytes;
+    TextureCategory category;
+} TextureRecord;
+
+void init_textures(void);
+void quit_textures(void);
+SDL_Texture *track_texture(SDL_Texture *texture, TextureCategory category);
+void destroy_texture(SDL_Texture *texture);
+Sint64 get_texture_usage(void);
+Sint64 get_menu_texture_usage(void);
+bool texture_budget_exceeded(void);
+void log_texture_usage(void);
@@ -3,13 +3,15 @@
 #include <stdarg.h>
 #include <string.h>
 #include <stdbool.h>
-#include <time.h>
 #include <getopt.h>
 #include <SDL.h>
 #include <SDL_syswm.h>
 #include "launcher.h"
 #include <launcher_config.h>
 #include "util.h"
+#include "icons.h"
+#include "atlas.h"
+#include "sources.h"
 #include "debug.h"
 #include "platform/platform.h"
 #include "external/ini.h"
@@ -17,12 +19,20 @@
 static void add_gamepad_control(const char *label, const char *cmd);
 static bool parse_mode_setting(ModeSettingType type, const char *value, int *setting);
 static Menu *create_menu(const char *menu_name, size_t *num_menus);
+static EntryInfo *append_entry(Menu *menu);
+static void index_menu(Menu *menu);
+static bool parse_directory_setting(Menu *menu, const char *name, const char *value);
+static void resolve_menu_rows(void);
 
 extern Config          config;
 extern GamepadControl  *gamepad_controls;
 extern Hotkey          *hotkeys;
+extern SDL_Renderer    *renderer;
 Menu                   *menu  = NULL;
-Entry                  *entry = NULL;
+static StringTable     menu_table = { NULL };
+static Menu            **indexed_menus = NULL;
+static int             num_indexed_menus = 0;
+static int             max_indexed_menus = 0;
 
 static const char *mode_settings[][6] = {
     {"Color", "Image", "Slideshow", "Transparent", "Video", NULL}, // Background Mode
@@ -122,6 +132,7 @@ void parse_config_file(const char *config_file_path)
     
     if (error < 0)
         log_fatal("Could not parse config file");
+    resolve_menu_rows();
 }
 
 // A function to handle config file parsing
@@ -152,6 +163,16 @@ int config_handler(void *user, const char *section, const char *name, const char
             convert_bool(value, &config.wrap_entries);
         else if (MATCH(name, SETTING_RESET_ON_BACK))
             convert_bool(value, &config.reset_on_back);
+        else if (MATCH(name, SETTING_PREFETCH_SIZE)) {
+            int prefetch_size = atoi(value);
+            if (prefetch_size >= 0 && prefetch_size <= MAX_PREFETCH_SIZE)
+                config.prefetch_size = (unsigned int) prefetch_size;
+        }
+        else if (MATCH(name, SETTING_TEXTURE_BUDGET)) {
+            int texture_budget = atoi(value);
+            if (texture_budget >= 0 && texture_budget <= MAX_TEXTURE_BUDGET)
+                config.texture_budget = (unsigned int) texture_budget;
+        }
         else if (MATCH(name, SETTING_MOUSE_SELECT))
             convert_bool(value, &config.mouse_select);
         else if (MATCH(name, SETTING_INHIBIT_OS_SCREENSAVER))
@@ -168,6 +189,11 @@ int config_handler(void *user, const char *section, const char *name, const char
             if (max_buttons > 0)
                 config.max_buttons = (unsigned int) max_buttons;
         }
+        else if (MATCH(name, SETTING_ROWS)) {
+            int rows = atoi(value);
+            if (rows > 0)
+                config.rows = (unsigned int) rows;
+        }
         else if (MATCH(name, SETTING_ICON_SIZE)) {
             Uint16 icon_size = (Uint16) atoi(value);
             if (icon_size >= MIN_ICON_SIZE && icon_size <= MAX_ICON_SIZE)
@@ -212,6 +238,13 @@ int config_handler(void *user, const char *section, const char *name, const char
             if (slideshow_transition_time <= MAX_SLIDESHOW_TRANSITION_TIME)
                 config.slideshow_transition_time = slideshow_transition_time;
         }
+        else if (MATCH(name, SETTING_SLIDESHOW_HISTORY_SIZE)) {
+            int slideshow_history_size = atoi(value);
+            if (slideshow_history_size >= 0 && slideshow_history_size <= MAX_SLIDESHOW_HISTORY_SIZE)
+                config.slideshow_history_size = (unsigned int) slideshow_history_size;
+        }
+        else if (MATCH(name, SETTING_SLIDESHOW_PAN_ZOOM))
+            convert_bool(value, &config.slideshow_pan_zoom);
         else if (MATCH(name, SETTING_CHROMA_KEY_COLOR))
             hex_to_color(value, &config.chroma_key_color);
         else if (MATCH(name, SETTING_BACKGROUND_OVERLAY))
@@ -222,6 +255,11 @@ int config_handler(void *user, const char *section, const char *name, const char
             if (is_percent(value))
                 copy_string(config.background_overlay_opacity, value, sizeof(config.background_overlay_opacity));
         }
+        else if (MATCH(name, SETTING_IMAGE_CACHE_SIZE)) {
+            int image_cache_size = atoi(value);
+            if (image_cache_size >= 0 && image_cache_size <= MAX_IMAGE_CACHE_SIZE)
+                config.image_cache_size = (unsigned int) image_cache_size;
+        }
     }
 
     else if (MATCH(section, "Titles")) {
@@ -350,6 +388,20 @@ int config_handler(void *user, const char *section, const char *name, const char
             convert_bool(value, &config.clock_include_weekday);
     }
 
+    else if (MATCH(section, "Status")) {
+        if (MATCH(name, SETTING_STATUS_ENABLED))
+            convert_bool(value, &config.status_enabled);
+        else if (MATCH(name, SETTING_STATUS_TEXT)) {
+            free(config.status_text);
+            config.status_text = strdup(value);
+        }
+        else if (MATCH(name, SETTING_STATUS_ALIGNMENT))
+            parse_mode_setting(MODE_SETTING_ALIGNMENT, value, (int*) &config.status_alignment);
+    }
+
+    else if (MATCH(section, "Sources"))
+        add_source(name, value);
+
     else if (MATCH(section, "Screensaver")) {
         if (MATCH(name, SETTING_SCREENSAVER_ENABLED))
             convert_bool(value, &config.screensaver_enabled);
@@ -393,93 +445,178 @@ int config_handler(void *user, const char *section, const char *name, const char
 
     // Parse menus/entries
     else {
-        Entry *previous_entry = NULL;
-
-        // Check if menu struct exists for current section
-        if (config.first_menu == NULL) {
-            config.first_menu = create_menu(section, &config.num_menus);
-            menu = config.first_menu;
+        // Look up the menu struct of the current section, create
+        // it at the end of the linked list if it doesn't exist yet
+        Menu *section_menu = find_menu(section);
+        if (section_menu == NULL) {
+            section_menu = create_menu(section, &config.num_menus);
+            if (config.first_menu == NULL)
+                config.first_menu = section_menu;
+            else
+                menu->next = section_menu;
+            menu = section_menu;
         }
-        else {
-            bool menu_exists = false;
-            for (Menu *tmp = config.first_menu; tmp != NULL;
-            tmp = tmp->next) {
-                if (MATCH(tmp->name,section)) {
-                    menu_exists = true;
-                    break;
-                }
-            }
-
-        // Create menu if it doesn't already exist
-            if (menu_exists == false) {
-                menu->next = create_menu(section, &config.num_menus);
-                menu = menu->next;
-            }
+        if (parse_directory_setting(section_menu, name, value))
+            return 0;
+        if (MATCH(name, SETTING_MENU_ROWS)) {
+            if (section_menu->rows == NULL)
+                section_menu->rows = calloc(1, sizeof(MenuRows));
+            free(section_menu->rows->names);
+            section_menu->rows->names = strdup(value);
+            return 0;
         }
 
         // Parse entry line for title, icon path, command
         char *string = (char*) value;
-        char *token;
+        char *tokens[3] = {NULL, NULL, NULL};
         char *delimiter = ";";
-        token = strtok(string, delimiter);
-        if (token != NULL) {
-
-            // Create first entry in the menu if none exists
-            if (menu->first_entry == NULL) {
-                menu->first_entry = malloc(sizeof(Entry));
-                entry = menu->first_entry;
-                entry->next = NULL;
-            }
-
-            // Add entry to the end of the linked list
-            else {
-                previous_entry = entry;
-                entry = entry->next;
-                entry = malloc(sizeof(Entry));
-                previous_entry->next = entry;
-                entry->next = NULL;
-            }
-            entry->title_offset = 0;
-        }
-
-        // Store data in entry struct
+        char *token = strtok(string, delimiter);
         int i;
-        for (i = 0;i < 3 && token != NULL; i++) {
-            if (i == 0)
-                entry->title = strdup(token);
-            else if (i == 1) {
-                entry->icon_path = strdup(token);
-                clean_path(entry->icon_path);
+        for (i = 0; i < 3 && token != NULL; i++) {
+            tokens[i] = token;
+            if (i == 1)
                 delimiter = "";
-            }
-            else if (i == 2)
-                entry->cmd = strdup(token);
-
             token = strtok(NULL, delimiter);
         }
 
-        // Delete entry if parse failed to find 3 valid tokens
-        if (i != 3 || MATCH(":select", entry->cmd)) {
-            if (menu->num_entries == 0) {
-                free(menu->first_entry);
-                menu->first_entry = NULL;
-            }
-            else {
-                free(entry);
-                entry = previous_entry;
-                entry->next = NULL;
-            }
+        // Skip entry if parse failed to find 3 valid tokens
+        if (i == 3 && !MATCH(":select", tokens[2]))
+            add_entry(section_menu, tokens[0], tokens[1], tokens[2]);
+    }
+    return 0;
+}
+
+// A function to parse the settings of a menu that lists the files of a directory
+static bool parse_directory_setting(Menu *menu, const char *name, const char *value)
+{
+    static const char *names[] = {
+        SETTING_MENU_DIRECTORY,
+        SETTING_MENU_ICON_DIRECTORY,
+        SETTING_MENU_DEFAULT_ICON,
+        SETTING_MENU_COMMAND,
+        SETTING_MENU_EXTENSIONS
+    };
+    size_t i;
+    for (i = 0; i < sizeof(names) / sizeof(names[0]) && !MATCH(name, names[i]); i++);
+    if (i == sizeof(names) / sizeof(names[0]))
+        return false;
+
+    if (menu->source == NULL)
+        menu->source = calloc(1, sizeof(DirectorySource));
+    DirectorySource *source = menu->source;
+    char **settings[] = {
+        &source->directory,
+        &source->icon_directory,
+        &source->default_icon,
+        &source->command,
+        &source->extensions
+    };
+    free(*settings[i]);
+    *settings[i] = strdup(value);
+
+    // The first settings are paths
+    if (i < 3)
+        clean_path(*settings[i]);
+    return true;
+}
+
+// A function to make room for an entry at the end of a menu, the layout
+// and the strings of the entries are stored in separate arrays
+static EntryInfo *append_entry(Menu *menu)
+{
+    if (menu->num_entries == menu->max_entries) {
+        menu->max_entries = menu->max_entries ? 2 * menu->max_entries : MIN_MENU_ENTRIES;
+        menu->entries = realloc(menu->entries, menu->max_entries * sizeof(Entry));
+        menu->entry_info = realloc(menu->entry_info, menu->max_entries * sizeof(EntryInfo));
+    }
+    Entry *entry = menu->entries + menu->num_entries;
+    *entry = (Entry) {
+        .icon = NULL,
+        .icon_selected = NULL,
+        .title_region = {NULL, {0, 0, 0, 0}, {0, 0, 0, 0}},
+        .title_offset = 0,
+        .loaded = false,
+        .job = NULL
+    };
+    return menu->entry_info + menu->num_entries++;
+}
+
+// A function to look up the menus shown as rows of other menus, once
+// all menus are defined. Menus that can't be shown as a row are skipped.
+static void resolve_menu_rows()
+{
+    for (Menu *home = config.first_menu; home != NULL; home = home->next) {
+        MenuRows *rows = home->rows;
+        if (rows == NULL)
+            continue;
+        unsigned int max_rows = 1;
+        for (const char *p = rows->names; *p != '\0'; p++) {
+            if (*p == ';')
+                max_rows++;
         }
-        else {
-            if (menu->num_entries == 0)
-                entry->previous = NULL;
-            else
-                entry->previous = previous_entry;
-            menu->num_entries++;
-            entry->icon_selected_path = selected_path(entry->icon_path);
+        rows->menus = malloc(max_rows * sizeof(Menu*));
+        for (char *name = strtok(rows->names, ";"); name != NULL; name = strtok(NULL, ";")) {
+            Menu *row = get_menu(name);
+            if (row == NULL)
+                continue;
+            if (row->rows != NULL) {
+                log_error("Menu '%s' has rows itself and can't be shown as a row of menu '%s'", name, home->name);
+                continue;
+            }
+            bool duplicate = false;
+            for (unsigned int i = 0; i < rows->num_rows; i++)
+                duplicate = duplicate || rows->menus[i] == row;
+            if (!duplicate)
+                rows->menus[rows->num_rows++] = row;
         }
+        free(rows->names);
+        rows->names = NULL;
     }
-    return 0;
+}
+
+// A function to add an entry to the end of a menu
+void add_entry(Menu *menu, const char *title, const char *icon_path, const char *cmd)
+{
+    EntryInfo *info = append_entry(menu);
+    info->title = strdup(title);
+    info->icon_path = NULL;
+    info->icon_selected_path = NULL;
+    if (icon_path != NULL) {
+        info->icon_path = strdup(icon_path);
+        clean_path(info->icon_path);
+        info->icon_selected_path = selected_path(info->icon_path);
+    }
+    info->cmd = strdup(cmd);
+}
+
+// A function to add a copy of an entry of another menu to the end of a menu,
+// the paths are already clean so the selected icon isn't looked up again
+void copy_entry(Menu *menu, const EntryInfo *entry_info)
+{
+    EntryInfo *info = append_entry(menu);
+    info->title = strdup(entry_info->title);
+    info->icon_path = entry_info->icon_path == NULL ? NULL : strdup(entry_info->icon_path);
+    info->icon_selected_path = entry_info->icon_selected_path == NULL ? NULL : strdup(entry_info->icon_selected_path);
+    info->cmd = strdup(entry_info->cmd);
+}
+
+// A function to remove the entries of a menu from an index on,
+// releasing their icons and titles
+void truncate_menu(Menu *menu, unsigned int num_entries)
+{
+    for (unsigned int i = num_entries; i < menu->num_entries; i++) {
+        EntryInfo *info = menu->entry_info + i;
+        free(info->title);
+        free(info->icon_path);
+        free(info->icon_selected_path);
+        free(info->cmd);
+        release_icon(menu->entries[i].icon);
+        release_icon(menu->entries[i].icon_selected);
+        if (renderer != NULL)
+            free_atlas_region(&menu->entries[i].title_region);
+    }
+    if (menu->num_entries > num_entries)
+        menu->num_entries = num_entries;
 }
 
 static bool parse_mode_setting(ModeSettingType type, const char *value, int *setting)
@@ -743,22 +880,135 @@ Uint16 get_unicode_code_point(const char *p, int *bytes)
     return result;
 }
 
-// A function to generate an array of random indices
-void random_array(int *array, int array_size)
+// A function to hash a string, FNV-1a
+Uint32 hash_string(const char *string)
+{
+    Uint32 hash = 0x811C9DC5;
+    for (const char *p = string; *p != '\0'; p++) {
+        hash ^= (Uint8) *p;
+        hash *= 0x01000193;
+    }
+    return hash;
+}
+
+// A function to add a key to a string table, the table
+// is grown to keep it at most half full
+void insert_string_index(StringTable *table, const char *key, int index)
+{
+    if (2 * (table->count + 1) > (table->slots == NULL ? 0 : table->mask + 1)) {
+        StringSlot *old_slots = table->slots;
+        Uint32 old_size = old_slots == NULL ? 0 : table->mask + 1;
+        Uint32 table_size = old_slots == NULL ? MIN_STRING_TABLE_SIZE : 2 * old_size;
+        while (table_size < 2 * (table->count + 1))
+            table_size *= 2;
+        table->slots = calloc(table_size, sizeof(StringSlot));
+        table->mask = table_size - 1;
+        for (Uint32 i = 0; i < old_size; i++) {
+            if (old_slots[i].key == NULL)
+                continue;
+            Uint32 slot = hash_string(old_slots[i].key) & table->mask;
+            while (table->slots[slot].key != NULL)
+                slot = (slot + 1) & table->mask;
+            table->slots[slot] = old_slots[i];
+        }
+        free(old_slots);
+    }
+
+    Uint32 slot = hash_string(key) & table->mask;
+    while (table->slots[slot].key != NULL)
+        slot = (slot + 1) & table->mask;
+    table->slots[slot] = (StringSlot) {
+        .key = key,
+        .index = index
+    };
+    table->count++;
+}
+
+// A function to look up the index of a key in a string table, -1 if not found
+int find_string_index(const StringTable *table, const char *key)
 {
-    // Fill array with initial indices
-    for (int i = 0; i < array_size; i++)
-        array[i] = i;
-
-    // Shuffle array indices randomly, see https://en.wikipedia.org/wiki/Fisher%E2%80%93Yates_shuffle
-    srand((unsigned int) time(NULL));
-    int tmp;
-    for (int i = 0; i < array_size - 1; i++) {
-        int j = (rand() % (array_size - i)) + i;
-        tmp = array[i];
-        array[i] = array[j];
-        array[j] = tmp;
+    if (table->slots == NULL)
+        return -1;
+    for (Uint32 slot = hash_string(key) & table->mask; table->slots[slot].key != NULL; slot = (slot + 1) & table->mask) {
+        if (MATCH(key, table->slots[slot].key))
+            return table->slots[slot].index;
     }
+    return -1;
+}
+
+// A function to remove a key from a string table. The keys after it in
+// the same cluster are moved back, so no lookup stops at the empty slot.
+void remove_string_index(StringTable *table, const char *key)
+{
+    if (table->slots == NULL)
+        return;
+    Uint32 slot = hash_string(key) & table->mask;
+    while (table->slots[slot].key != NULL && !MATCH(key, table->slots[slot].key))
+        slot = (slot + 1) & table->mask;
+    if (table->slots[slot].key == NULL)
+        return;
+    table->slots[slot].key = NULL;
+    table->count--;
+    for (Uint32 next = (slot + 1) & table->mask; table->slots[next].key != NULL; next = (next + 1) & table->mask) {
+        Uint32 home = hash_string(table->slots[next].key) & table->mask;
+
+        // Move the key into the empty slot if that is not before its home slot
+        if (((next - home) & table->mask) >= ((next - slot) & table->mask)) {
+            table->slots[slot] = table->slots[next];
+            table->slots[next].key = NULL;
+            slot = next;
+        }
+    }
+}
+
+// A function to free the slots of a string table
+void free_string_table(StringTable *table)
+{
+    free(table->slots);
+    *table = (StringTable) { NULL };
+}
+
+// A function to generate the next 64 bit random number, see https://prng.di.unimi.it/splitmix64.c
+Uint64 random_next(Uint64 *state)
+{
+    Uint64 z = (*state += 0x9E3779B97F4A7C15);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+    return z ^ (z >> 31);
+}
+
+// A function to initialize a random permutation of the indices 0 to size - 1
+void init_permutation(Permutation *permutation, Uint32 size, Uint64 *state)
+{
+    // The Feistel network needs an even number of bits covering the size
+    Uint32 bits = 2;
+    while (bits < 32 && ((Uint64) 1 << bits) < size)
+        bits += 2;
+    permutation->size = size;
+    permutation->half_bits = bits / 2;
+    for (int i = 0; i < PERMUTATION_ROUNDS; i++)
+        permutation->keys[i] = (Uint32) random_next(state);
+}
+
+// A function to map an index to its position in a random permutation with a
+// Feistel network, indices outside of the size are walked until they fit, see
+// https://en.wikipedia.org/wiki/Format-preserving_encryption#FPE_from_a_prefix_cipher
+Uint32 permute_index(Permutation *permutation, Uint32 index)
+{
+    Uint32 mask = (Uint32) (((Uint64) 1 << permutation->half_bits) - 1);
+    do {
+        Uint32 left = index >> permutation->half_bits;
+        Uint32 right = index & mask;
+        for (int i = 0; i < PERMUTATION_ROUNDS; i++) {
+            Uint32 f = (right ^ permutation->keys[i]) * 0x9E3779B1;
+            f ^= f >> 15;
+            Uint32 tmp = right;
+            right = (left ^ f) & mask;
+            left = tmp;
+        }
+        index = (left << permutation->half_bits) | right;
+    } while (index >= permutation->size);
+    return index;
 }
 
 // A function to calculate the total width of all screen objects
@@ -1026,6 +1276,29 @@ void validate_settings(Geometry *geo)
         vcenter = upper_limit;
     geo->y_margin = vcenter - button_height / 2;
 
+    // Reduce number of rows if they can't all fit on screen, center the grid
+    // on the centerline without letting it leave the screen
+    geo->y_advance = button_height + 2*config.highlight_vpadding + config.icon_spacing;
+    if (config.rows > 1) {
+        int max_height = geo->screen_height - 2*geo->screen_margin;
+        unsigned int rows;
+        for (rows = config.rows; rows > 1 && (int) (rows - 1)*geo->y_advance + button_height > max_height; rows--);
+        if (rows != config.rows) {
+            log_error(
+                "Not enough screen space for %i rows, reducing to %i",
+                config.rows,
+                rows
+            );
+            config.rows = rows;
+        }
+        int grid_height = (int) (config.rows - 1)*geo->y_advance + button_height;
+        geo->y_margin = vcenter - grid_height / 2;
+        if (geo->y_margin + grid_height > geo->screen_height - geo->screen_margin)
+            geo->y_margin = geo->screen_height - geo->screen_margin - grid_height;
+        if (geo->y_margin < geo->screen_margin)
+            geo->y_margin = geo->screen_margin;
+    }
+
     // Max highlight outline
     int max_highlight_outline_size = (config.highlight_hpadding < config.highlight_vpadding) 
                                      ? config.highlight_hpadding : config.highlight_vpadding;
@@ -1042,49 +1315,97 @@ void validate_settings(Geometry *geo)
         config.highlight_rx = 0;
 }
 
-// A function to retreive menu struct from the linked list via the menu name
+// A function to retreive menu struct via the menu name
 Menu *get_menu(const char *menu_name)
 {
-    for (Menu *menu = config.first_menu; menu != NULL; menu = menu->next) {
-        if (MATCH(menu_name, menu->name))
-            return menu;
+    Menu *menu = find_menu(menu_name);
+    if (menu == NULL)
+        log_error("Menu '%s' not found in config file", menu_name);
+    return menu;
+}
+
+// A function to look up a menu in the name index, NULL if not found
+Menu *find_menu(const char *menu_name)
+{
+    int index = find_string_index(&menu_table, menu_name);
+    return index != -1 ? indexed_menus[index] : NULL;
+}
+
+// A function to add a menu to the name index
+static void index_menu(Menu *menu)
+{
+    if (num_indexed_menus == max_indexed_menus) {
+        max_indexed_menus = max_indexed_menus ? 2 * max_indexed_menus : MIN_STRING_TABLE_SIZE;
+        indexed_menus = realloc(indexed_menus, (size_t) max_indexed_menus * sizeof(Menu*));
     }
-    log_error("Menu '%s' not found in config file", menu_name);
-    return NULL;
+    indexed_menus[num_indexed_menus] = menu;
+    insert_string_index(&menu_table, menu->name, num_indexed_menus++);
+}
+
+// A function to free the menu name index
+void free_menu_index()
+{
+    free_string_table(&menu_table);
+    free(indexed_menus);
+    indexed_menus = NULL;
+    num_indexed_menus = 0;
+    max_indexed_menus = 0;
 }
 
 // A function to allocate memory to and initialize a menu struct
-Menu *create_menu(const char *menu_name, size_t *num_menus)
+Menu *allocate_menu(const char *menu_name)
 {
     Menu *menu = malloc(sizeof(Menu));
     *menu = (Menu) {
-        .first_entry = NULL,
+        .entries = NULL,
+        .entry_info = NULL,
+        .source = NULL,
+        .rows = NULL,
         .next = NULL,
         .back = NULL,
-        .root_entry = NULL,
         .num_entries = 0,
+        .max_entries = 0,
         .page = 0,
         .highlight_position = 0,
-        .rendered = false
+        .load_start = 0,
+        .load_end = 0,
+        .num_jobs = 0,
+        .last_visit = 0
     };
     menu->name = strdup(menu_name);
+    return menu;
+}
+
+// A function to create a menu of the config file and add it to the name index
+static Menu *create_menu(const char *menu_name, size_t *num_menus)
+{
+    Menu *menu = allocate_menu(menu_name);
+    index_menu(menu);
     (*num_menus)++;
     
     return menu;
 }
 
-// A function to advance X spaces in the entry linked list (left or right)
-Entry *advance_entries(Entry *entry, int spaces, Direction direction)
+// A function to free a menu and its entries
+void free_menu(Menu *menu)
 {
-    if (direction == DIRECTION_LEFT) {
-        for (int i = 0; i < spaces; i++)
-            entry = entry->previous;
-    }
-    else if (direction == DIRECTION_RIGHT) {
-        for (int i = 0; i < spaces; i++)
-            entry = entry->next;
+    if (menu->rows != NULL) {
+        free(menu->rows->names);
+        free(menu->rows->menus);
+        free(menu->rows);
     }
-    return entry;
+    free(menu->name);
+    truncate_menu(menu, 0);
+    free(menu->entries);
+    free(menu->entry_info);
+    free(menu);
+}
+
+// A function to determine if icons or titles of a menu are being loaded,
+// including cancelled loads that still refer to the menu
+bool menu_loading(Menu *menu)
+{
+    return menu->num_jobs > 0;
 }
 
 // A function to dynamically allocate a buffer for and copy a formatted string
@@ -13,6 +13,8 @@
 #define LEN(x) ((sizeof(x)/sizeof(x[0])) - sizeof(x[0]))
 #define MATCH(x, y) !strcmp(x, y)
 
+#define MIN_STRING_TABLE_SIZE 16
+
 #define DIV_ROUND_UP(a, b) ((a + (b - 1)) / b)
 #define MIN(a, b) (((a) < (b)) ? (a) : (b))
 
@@ -38,7 +40,14 @@ void copy_string(char* dest, const char* string, size_t size);
 void utf8_truncate(char *string, int width, int max_width);
 void convert_percent_to_int(char *string, int *result, int max_value);
 void add_hotkey(const char *keycode, const char *cmd);
-void random_array(int *array, int array_size);
+Uint32 hash_string(const char *string);
+void insert_string_index(StringTable *table, const char *key, int index);
+int find_string_index(const StringTable *table, const char *key);
+void remove_string_index(StringTable *table, const char *key);
+void free_string_table(StringTable *table);
+Uint64 random_next(Uint64 *state);
+void init_permutation(Permutation *permutation, Uint32 size, Uint64 *state);
+Uint32 permute_index(Permutation *permutation, Uint32 index);
 void clean_path(char *path);
 void validate_settings(Geometry *geo);
 void parse_config_file(const char *config_file_path);
@@ -46,4 +55,11 @@ void read_file(const char *path, char **buffer);
 void sprintf_alloc(char **buffer, const char *format, ...);
 Uint16 get_unicode_code_point(const char *p, int *bytes);
 Menu *get_menu(const char *menu_name);
-Entry *advance_entries(Entry *entry, int spaces, Direction direction);
\ No newline at end of file
+Menu *find_menu(const char *menu_name);
+Menu *allocate_menu(const char *menu_name);
+void free_menu(Menu *menu);
+bool menu_loading(Menu *menu);
+void add_entry(Menu *menu, const char *title, const char *icon_path, const char *cmd);
+void copy_entry(Menu *menu, const EntryInfo *entry_info);
+void truncate_menu(Menu *menu, unsigned int num_entries);
+void free_menu_index(void);
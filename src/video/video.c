@@ -8,6 +8,7 @@
 #include "video.h"
 #include "../launcher.h"
 #include "../debug.h"
+#include "../textures.h"
 
 #define FRAME_BLOCK 64
 
@@ -342,7 +343,7 @@ void cleanup_video() {
 	SDL_WaitThread(video_render_thread, NULL);
         video_load_thread = NULL;
 	video_render_thread = NULL;
-	free(video_texture);
+	destroy_texture(video_texture);
 	video_texture = NULL;
 	sFrames* iter = (sFrames*) frames;
 	while (iter != NULL) {
@@ -412,7 +413,7 @@ static int draw_video_async(void* nothing) {
 	void *texture_pixels = NULL;
 	int pitch = 0;
 	const sFrame* currentFrame = NULL;
-	video_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA, SDL_TEXTUREACCESS_STREAMING, geo -> screen_width, geo -> screen_height);
+	video_texture = track_texture(SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA, SDL_TEXTUREACCESS_STREAMING, geo -> screen_width, geo -> screen_height), TEXTURE_VIDEO);
 	if (video_texture == NULL) {
 		log_error("Failed to load video texture");
 		return -1;
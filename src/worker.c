@@ -0,0 +1,222 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <SDL.h>
+#include "launcher.h"
+#include "worker.h"
+#include "util.h"
+#include "debug.h"
+
+static int run_jobs_async(void *data);
+static void post_completion(Job *job);
+
+// Worker pool state, the job queues are protected by the mutex
+static SDL_Thread *workers[MAX_WORKERS];
+static int num_workers          = 0;
+static SDL_mutex *worker_mutex  = NULL;
+static SDL_cond *worker_cond    = NULL;
+static Job *queue_head[NUM_PRIORITIES];
+static Job *queue_tail[NUM_PRIORITIES];
+static Job *completed_head      = NULL; // Jobs waiting for their completion callback
+static Job *completed_tail      = NULL;
+static bool wake_posted         = false; // The main thread was woken for the completed jobs
+static bool quit_requested      = false;
+static Uint32 worker_event_type = (Uint32) -1;
+
+// A function to start the persistent worker threads
+void init_workers()
+{
+    worker_event_type = SDL_RegisterEvents(1);
+    if (worker_event_type == (Uint32) -1)
+        log_fatal("Could not register worker event\n%s", SDL_GetError());
+    worker_mutex = SDL_CreateMutex();
+    worker_cond = SDL_CreateCond();
+    for (int i = 0; i < NUM_PRIORITIES; i++) {
+        queue_head[i] = NULL;
+        queue_tail[i] = NULL;
+    }
+
+    int count = SDL_GetCPUCount();
+    count = count < MIN_WORKERS ? MIN_WORKERS : MIN(count, MAX_WORKERS);
+    for (int i = 0; i < count; i++) {
+        workers[num_workers] = SDL_CreateThread(run_jobs_async, "Worker Thread", NULL);
+        if (workers[num_workers] == NULL) {
+            log_error("Could not create worker thread\n%s", SDL_GetError());
+            break;
+        }
+        num_workers++;
+    }
+    if (!num_workers)
+        log_fatal("Could not start any worker threads");
+    log_debug("Started %i worker threads", num_workers);
+}
+
+// A function to stop the worker threads, queued jobs are discarded
+void quit_workers()
+{
+    if (worker_mutex == NULL)
+        return;
+    SDL_LockMutex(worker_mutex);
+    quit_requested = true;
+    SDL_CondBroadcast(worker_cond);
+    SDL_UnlockMutex(worker_mutex);
+    for (int i = 0; i < num_workers; i++)
+        SDL_WaitThread(workers[i], NULL);
+    num_workers = 0;
+
+    for (int i = 0; i < NUM_PRIORITIES; i++) {
+        Job *next;
+        for (Job *job = queue_head[i]; job != NULL; job = next) {
+            next = job->next;
+            free(job);
+        }
+        queue_head[i] = NULL;
+        queue_tail[i] = NULL;
+    }
+    Job *next;
+    for (Job *job = completed_head; job != NULL; job = next) {
+        next = job->next;
+        free(job);
+    }
+    completed_head = NULL;
+    completed_tail = NULL;
+    SDL_DestroyCond(worker_cond);
+    SDL_DestroyMutex(worker_mutex);
+    worker_cond = NULL;
+    worker_mutex = NULL;
+}
+
+// A function to queue a job, the completion callback is called on the main
+// thread once the job has run or was cancelled. The returned handle is
+// valid until the completion callback returns.
+Job *submit_job(JobPriority priority, JobFunction run, JobCallback complete, void *data)
+{
+    Job *job = malloc(sizeof(Job));
+    *job = (Job) {
+        .run = run,
+        .complete = complete,
+        .data = data,
+        .priority = priority,
+        .queued = true,
+        .cancelled = false,
+        .next = NULL
+    };
+    SDL_LockMutex(worker_mutex);
+    if (queue_tail[priority] == NULL)
+        queue_head[priority] = job;
+    else
+        queue_tail[priority]->next = job;
+    queue_tail[priority] = job;
+    SDL_CondSignal(worker_cond);
+    SDL_UnlockMutex(worker_mutex);
+    return job;
+}
+
+// A function to cancel a job, a queued job is removed without running, a running
+// job finishes but its completion callback is told it was cancelled
+void cancel_job(Job *job)
+{
+    bool removed = false;
+    SDL_LockMutex(worker_mutex);
+    job->cancelled = true;
+    if (job->queued) {
+        Job *previous = NULL;
+        for (Job *i = queue_head[job->priority]; i != NULL; previous = i, i = i->next) {
+            if (i != job)
+                continue;
+            if (previous == NULL)
+                queue_head[job->priority] = job->next;
+            else
+                previous->next = job->next;
+            if (queue_tail[job->priority] == job)
+                queue_tail[job->priority] = previous;
+            break;
+        }
+        job->queued = false;
+        removed = true;
+    }
+    SDL_UnlockMutex(worker_mutex);
+    if (removed)
+        post_completion(job);
+}
+
+// A function to run queued jobs in a worker thread, highest priority first
+static int run_jobs_async(void *data)
+{
+    (void) data;
+    SDL_LockMutex(worker_mutex);
+    while (!quit_requested) {
+        Job *job = NULL;
+        for (int i = 0; i < NUM_PRIORITIES && job == NULL; i++)
+            job = queue_head[i];
+        if (job == NULL) {
+            SDL_CondWait(worker_cond, worker_mutex);
+            continue;
+        }
+        queue_head[job->priority] = job->next;
+        if (queue_head[job->priority] == NULL)
+            queue_tail[job->priority] = NULL;
+        job->queued = false;
+        job->next = NULL;
+        SDL_UnlockMutex(worker_mutex);
+
+        job->run(job->data);
+        post_completion(job);
+        SDL_LockMutex(worker_mutex);
+    }
+    SDL_UnlockMutex(worker_mutex);
+    return 0;
+}
+
+// A function to add a job that is done to the completed jobs, an event
+// wakes the main thread if it is waiting for events. The job stays in the
+// list if the event can't be posted, so its callback still runs the next
+// time the main thread completes jobs.
+static void post_completion(Job *job)
+{
+    SDL_LockMutex(worker_mutex);
+    job->next = NULL;
+    if (completed_tail == NULL)
+        completed_head = job;
+    else
+        completed_tail->next = job;
+    completed_tail = job;
+    bool wake = !wake_posted;
+    wake_posted = true;
+    SDL_UnlockMutex(worker_mutex);
+    if (!wake)
+        return;
+
+    SDL_Event event;
+    SDL_zero(event);
+    event.type = worker_event_type;
+    if (SDL_PushEvent(&event) <= 0) {
+        log_error("Could not wake the main thread for completed jobs\n%s", SDL_GetError());
+        SDL_LockMutex(worker_mutex);
+        wake_posted = false;
+        SDL_UnlockMutex(worker_mutex);
+    }
+}
+
+// A function to call the completion callbacks of the jobs that are done on
+// the main thread, returns true if any job was completed
+bool complete_jobs()
+{
+    SDL_LockMutex(worker_mutex);
+    Job *job = completed_head;
+    completed_head = NULL;
+    completed_tail = NULL;
+    wake_posted = false;
+    SDL_UnlockMutex(worker_mutex);
+
+    // Jobs are only cancelled on the main thread, the flag can be read without the lock
+    bool completed = job != NULL;
+    Job *next;
+    for (; job != NULL; job = next) {
+        next = job->next;
+        if (job->complete != NULL)
+            job->complete(job->data, job->cancelled);
+        free(job);
+    }
+    return completed;
+}
@@ -0,0 +1,30 @@
+#define MAX_WORKERS 4
+#define MIN_WORKERS 2
+
+typedef void (*JobFunction)(void *data);
+typedef void (*JobCallback)(void *data, bool cancelled);
+
+// Priority classes of jobs, higher priority jobs run first
+typedef enum {
+    PRIORITY_INTERACTIVE,
+    PRIORITY_BACKGROUND,
+    PRIORITY_IDLE,
+    NUM_PRIORITIES
+} JobPriority;
+
+// Job for the worker pool
+typedef struct job {
+    JobFunction run;
+    JobCallback complete;
+    void *data;
+    JobPriority priority;
+    bool queued;
+    bool cancelled;
+    struct job *next;
+} Job;
+
+void init_workers(void);
+void quit_workers(void);
+Job *submit_job(JobPriority priority, JobFunction run, JobCallback complete, void *data);
+void cancel_job(Job *job);
+bool complete_jobs(void);